@@ -0,0 +1,272 @@
+// heap.cc
+//     	Routines to manage a priority queue of "things", kept as a
+//	binary heap in an array.
+//
+//	Each item is stamped with the number of items inserted before
+//	it, so that items that compare equal come out first in, first
+//	out.  The stamps are compared modulo 2^32, so they only need
+//	to be unique among the items in the heap at any one time.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+const int InitialHeapSize = 16;	// elements to allocate to start with
+
+//----------------------------------------------------------------------
+// Heap<T>::Heap
+//	Initialize a heap, empty to start with.
+//
+//	"comp" is the function that orders the items in the heap
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::Heap(int (*comp)(T x, T y))
+{
+    compare = comp;
+    maxInHeap = InitialHeapSize;
+    elements = new HeapElement<T>[maxInHeap];
+    numInHeap = 0;
+    numInserted = 0;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::~Heap
+//	Prepare a heap for deallocation.
+//      This does *NOT* free any of the items in the heap.
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::~Heap()
+{
+    delete [] elements;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Less
+//	Return TRUE if element "i" should come out of the heap before
+//	element "j": it is smaller, or it is equal and was put in first.
+//----------------------------------------------------------------------
+
+template <class T>
+bool
+Heap<T>::Less(int i, int j) const
+{
+    int result = compare(elements[i].item, elements[j].item);
+
+    if (result != 0) {
+	return (result < 0);
+    }
+    return ((int) (elements[i].order - elements[j].order) < 0);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Swap
+//	Exchange elements "i" and "j".
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Swap(int i, int j)
+{
+    HeapElement<T> tmp = elements[i];
+
+    elements[i] = elements[j];
+    elements[j] = tmp;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftUp
+//	Restore the heap property after element "i" may have become
+//	smaller than its parent, by swapping it with its parent until
+//	it isn't.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftUp(int i)
+{
+    while (i > 0 && Less(i, (i - 1) / 2)) {
+	Swap(i, (i - 1) / 2);
+	i = (i - 1) / 2;
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftDown
+//	Restore the heap property after element "i" may have become
+//	bigger than one of its children, by swapping it with its
+//	smaller child until it isn't.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftDown(int i)
+{
+    int child;
+
+    while ((child = 2 * i + 1) < numInHeap) {
+	if (child + 1 < numInHeap && Less(child + 1, child)) {
+	    child++;
+	}
+	if (!Less(child, i)) {
+	    break;
+	}
+	Swap(i, child);
+	i = child;
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Insert
+//      Put an item into the heap, after any items already in the
+//	heap that compare equal to it.  If the array is full, double it.
+//
+//	"item" is the thing to put in the heap.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Insert(T item)
+{
+    if (numInHeap == maxInHeap) {
+	HeapElement<T> *bigger = new HeapElement<T>[2 * maxInHeap];
+
+	for (int i = 0; i < numInHeap; i++) {
+	    bigger[i] = elements[i];
+	}
+	delete [] elements;
+	elements = bigger;
+	maxInHeap *= 2;
+    }
+    elements[numInHeap].item = item;
+    elements[numInHeap].order = numInserted++;
+    numInHeap++;
+    SiftUp(numInHeap - 1);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveFront
+//      Remove the smallest item from the heap, and return it.
+//	The heap must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+Heap<T>::RemoveFront()
+{
+    T item;
+
+    ASSERT(!IsEmpty());
+    item = elements[0].item;
+    numInHeap--;
+    if (numInHeap > 0) {
+	elements[0] = elements[numInHeap];
+	SiftDown(0);
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Remove
+//      Remove a specific item from the heap.  Must be in the heap!
+//
+//	This has to look for the item, so takes O(n) time.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Remove(T item)
+{
+    int i;
+
+    for (i = 0; i < numInHeap; i++) {
+	if (elements[i].item == item) {
+	    break;
+	}
+    }
+    ASSERT(i < numInHeap);
+
+    numInHeap--;
+    if (i < numInHeap) {		// fill the hole with the last element
+	elements[i] = elements[numInHeap];
+	SiftUp(i);
+	SiftDown(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Apply
+//      Apply function to every item in the heap, in no particular order.
+//
+//	"func" is the procedure to apply.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Apply(void (*func)(T)) const
+{
+    for (int i = 0; i < numInHeap; i++) {
+	(*func)(elements[i].item);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap::SanityCheck
+//      Test whether this is still a legal heap.
+//
+//	Test: is each element no smaller than its parent?
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SanityCheck() const
+{
+    ASSERT(numInHeap >= 0 && numInHeap <= maxInHeap);
+    for (int i = 1; i < numInHeap; i++) {
+	ASSERT(!Less(i, (i - 1) / 2));
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SelfTest(T *p, int numEntries)
+{
+    int i, j;
+    T last, next;
+
+    ASSERT(IsEmpty());
+
+    // put everything in several times, to force the array to grow
+    for (j = 0; j < InitialHeapSize; j++) {
+	for (i = 0; i < numEntries; i++) {
+	    Insert(p[i]);
+	}
+	SanityCheck();
+    }
+    ASSERT(NumInHeap() == InitialHeapSize * numEntries);
+
+    // take one copy of each item back out
+    for (i = 0; i < numEntries; i++) {
+	Remove(p[i]);
+	SanityCheck();
+    }
+
+    // should be able to get out everything else, in the right order
+    last = RemoveFront();
+    while (!IsEmpty()) {
+	next = RemoveFront();
+	ASSERT(compare(last, next) <= 0);
+	last = next;
+    }
+    SanityCheck();
+}
@@ -0,0 +1,101 @@
+// heap.h
+//	Data structures to manage a priority queue, as a binary heap.
+//
+//	Like a SortedList, a heap always gives back its smallest item
+//	first, but it takes O(log n) time to insert or remove an item,
+//	rather than O(n), and it allocates nothing per item: the items
+//	are kept in an array that grows as needed.
+//
+//	Items that compare equal come out in the order they were put
+//	in, as they would from a SortedList.
+//
+//	Allocation and deallocation of the items in the heap are to be
+//	done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a "heap element" -- which is used
+// to keep track of one item in a heap, along with when it was put
+// in, to break ties between items that compare equal.
+//
+// This class is private to this module. Made public for notational
+// convenience.
+
+template <class T>
+class HeapElement {
+  public:
+    T item;			// item in the heap
+    unsigned int order;		// how many items were inserted before it
+};
+
+// The following class defines a "heap" -- an array of heap elements,
+// arranged so that each element is no bigger than its two children
+// (elements 2i+1 and 2i+2 are the children of element i).
+// All types to be put in a heap must have a "Compare" function
+// defined, as for a SortedList:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+
+template <class T>
+class Heap {
+  public:
+    Heap(int (*comp)(T x, T y));// initialize the heap
+    ~Heap();			// de-allocate the heap
+
+    void Insert(T item); 	// put an item into the heap
+
+    T Front() { ASSERT(numInHeap > 0); return elements[0].item; }
+    				// Return smallest item in the heap
+				// without removing it
+    T RemoveFront(); 		// Take smallest item out of the heap
+    void Remove(T item); 	// Remove specific item from the heap
+
+    T Item(int i) { ASSERT(i >= 0 && i < numInHeap);
+			return elements[i].item; }
+				// Return the i'th item, in no
+				// particular order, for looking
+				// through every item in the heap
+
+    int NumInHeap() { return numInHeap; };
+    				// how many items in the heap?
+    bool IsEmpty() { return (numInHeap == 0); };
+    				// is the heap empty?
+
+    void Apply(void (*f)(T)) const;
+    				// apply function to all items in the
+				// heap, in no particular order
+
+    void SanityCheck() const;	// has this heap been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    int (*compare)(T x, T y);	// function for ordering the items
+    HeapElement<T> *elements;	// the heap; elements[0] is smallest
+    int numInHeap;		// number of items in the heap
+    int maxInHeap;		// number of elements allocated
+    unsigned int numInserted;	// stamp for the next item inserted
+
+    bool Less(int i, int j) const;
+				// does element i come out before j?
+    void Swap(int i, int j);	// exchange elements i and j
+    void SiftUp(int i);		// move element i up until its parent
+				// is no bigger
+    void SiftDown(int i);	// move element i down until its children
+				// are no smaller
+};
+
+#include "heap.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // HEAP_H
@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, heaps, red-black trees,
+//	and hash tables.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -10,13 +11,15 @@
 #include "libtest.h"
 #include "bitmap.h"
 #include "list.h"
+#include "heap.h"
+#include "rbtree.h"
 #include "hash.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
 // IntCompare
 //	Compare two integers together.  Serves as the comparison
-//	function for testing SortedLists
+//	function for testing SortedLists, Heaps and RBTrees
 //----------------------------------------------------------------------
 
 static int 
@@ -50,7 +53,7 @@ HashKey(char *str) {
     return atoi(str);
 }
 
-// Array of values to be inserted into a List or SortedList. 
+// Array of values to be inserted into a List, SortedList, Heap or RBTree. 
 static int listTestVector[] = { 9, 5, 7 };
 
 // Array of values to be inserted into the HashTable
@@ -60,8 +63,8 @@ static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
 
 //----------------------------------------------------------------------
 // LibSelfTest
-//	Run self tests on bitmaps, lists, sorted lists, and 
-//	hash tables.
+//	Run self tests on bitmaps, lists, sorted lists, heaps, red-black
+//	trees, and hash tables.
 //----------------------------------------------------------------------
 
 void
@@ -69,6 +72,8 @@ LibSelfTest () {
     Bitmap *map = new Bitmap(200);
     List<int> *list = new List<int>;
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
+    Heap<int> *heap = new Heap<int>(IntCompare);
+    RBTree<int> *tree = new RBTree<int>(IntCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
 	
@@ -76,10 +81,14 @@ LibSelfTest () {
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    heap->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    tree->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
 
     delete map;
     delete list;
     delete sortList;
+    delete heap;
+    delete tree;
     delete hashTable;
 }
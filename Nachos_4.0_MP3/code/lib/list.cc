@@ -18,6 +18,10 @@
 
 #include "copyright.h"
 
+template <class T> Slab ListElement<T>::slab("list element");
+template <class T> Slab List<T>::slab("list");
+template <class T> Slab SortedList<T>::slab("sorted list");
+
 //----------------------------------------------------------------------
 // ListElement<T>::ListElement
 // 	Initialize a list element, so it can be added somewhere on a list.
@@ -236,7 +240,7 @@ SortedList<T>::Insert(T item)
     ListElement<T> *element = new ListElement<T>(item);
     ListElement<T> *ptr;		// keep track
 
-    ASSERT(!IsInList(item));
+    ASSERT(!this->IsInList(item));
     if (this->IsEmpty()) {			// if list is empty, put at front
         this->first = element;
         this->last = element;
@@ -256,7 +260,7 @@ SortedList<T>::Insert(T item)
 	this->last = element;
     }
     this->numInList++;
-    ASSERT(IsInList(item));
+    ASSERT(this->IsInList(item));
 }
 
 //----------------------------------------------------------------------
@@ -362,14 +366,14 @@ SortedList<T>::SelfTest(T *p, int numEntries)
 
     for (i = 0; i < numEntries; i++) {
 	 Insert(p[i]);
-	 ASSERT(IsInList(p[i]));
+	 ASSERT(this->IsInList(p[i]));
      }
      SanityCheck();
 
      // should be able to get out everything we put in
      for (i = 0; i < numEntries; i++) {
 	 q[i] = this->RemoveFront();
-         ASSERT(!IsInList(q[i]));
+         ASSERT(!this->IsInList(q[i]));
      }
      ASSERT(this->IsEmpty());
 
@@ -15,6 +15,7 @@
 
 #include "copyright.h"
 #include "debug.h"
+#include "slab.h"
 
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
@@ -30,6 +31,12 @@ class ListElement {
     ListElement(T itm); 	// initialize a list element
     ListElement *next;	     	// next element on list, NULL if this is last
     T item; 	   	     	// item on the list
+
+    void *operator new(size_t size) { return slab.Alloc(size); }
+    void operator delete(void *p, size_t size) { slab.Free(p, size); }
+    static Slab slab;		// where list elements are allocated, so
+				// that Append and Remove don't go to the
+				// host's allocator each time
 };
 
 // The following class defines a "list" -- a singly linked list of
@@ -76,6 +83,12 @@ class List {
     int numInList;		// number of elements in list
 
     friend class ListIterator<T>;
+
+  public:
+    void *operator new(size_t size) { return slab.Alloc(size); }
+    void operator delete(void *p, size_t size) { slab.Free(p, size); }
+    static Slab slab;		// where lists are allocated (every
+				// semaphore has one)
 };
 
 // The following class defines a "sorted list" -- a singly linked list of
@@ -107,6 +120,11 @@ class SortedList : public List<T> {
 				             //	in a sorted list
     void Append(T item) { Insert(item); }   // neither does *ap*pend 
 
+  public:
+    void *operator new(size_t size) { return slab.Alloc(size); }
+    void operator delete(void *p, size_t size) { slab.Free(p, size); }
+    static Slab slab;		// where sorted lists are allocated -- not
+				// List's slab, they are bigger than lists
 };
 
 // The following class can be used to step through a list. 
@@ -0,0 +1,559 @@
+// rbtree.cc
+//     	Routines to manage a red-black tree of "things".
+//
+//	The algorithms are the usual ones (see, for example, Cormen,
+//	Leiserson and Rivest, "Introduction to Algorithms", chapter 14),
+//	with NULL pointers for the leaves, which count as black.
+//
+//	An item that compares equal to items already in the tree goes
+//	to their right, so that equal items come out first in, first out.
+//	The tree also remembers its leftmost node, so Front takes O(1)
+//	time.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+template <class T> Slab RBNode<T>::slab("tree node");
+
+//----------------------------------------------------------------------
+// RBNode<T>::RBNode
+// 	Initialize a node, red and with no children, so it can be put
+//	in a tree.
+//
+//	"itm" is the item to be put in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+RBNode<T>::RBNode(T itm)
+{
+    item = itm;
+    left = right = parent = NULL;
+    red = TRUE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RBTree
+//	Initialize a tree, empty to start with.
+//
+//	"comp" is the function that orders the items in the tree
+//----------------------------------------------------------------------
+
+template <class T>
+RBTree<T>::RBTree(int (*comp)(T x, T y))
+{
+    compare = comp;
+    root = leftmost = NULL;
+    numInTree = 0;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::~RBTree
+//	Prepare a tree for deallocation.
+//      This does *NOT* free any of the items in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+RBTree<T>::~RBTree()
+{
+    DeleteAll(root);
+}
+
+template <class T>
+void
+RBTree<T>::DeleteAll(RBNode<T> *node)
+{
+    if (node != NULL) {
+	DeleteAll(node->left);
+	DeleteAll(node->right);
+	delete node;
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RotateLeft, RotateRight
+//	Rotate the tree around "node": its right (left) child takes its
+//	place, and it becomes that child's left (right) child.  The
+//	order of the items doesn't change.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::RotateLeft(RBNode<T> *node)
+{
+    RBNode<T> *child = node->right;
+
+    node->right = child->left;
+    if (child->left != NULL) {
+	child->left->parent = node;
+    }
+    child->parent = node->parent;
+    if (node->parent == NULL) {
+	root = child;
+    } else if (node == node->parent->left) {
+	node->parent->left = child;
+    } else {
+	node->parent->right = child;
+    }
+    child->left = node;
+    node->parent = child;
+}
+
+template <class T>
+void
+RBTree<T>::RotateRight(RBNode<T> *node)
+{
+    RBNode<T> *child = node->left;
+
+    node->left = child->right;
+    if (child->right != NULL) {
+	child->right->parent = node;
+    }
+    child->parent = node->parent;
+    if (node->parent == NULL) {
+	root = child;
+    } else if (node == node->parent->right) {
+	node->parent->right = child;
+    } else {
+	node->parent->left = child;
+    }
+    child->right = node;
+    node->parent = child;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Insert
+//      Put an item into the tree, after any items already in the
+//	tree that compare equal to it.
+//
+//	"item" is the thing to put in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::Insert(T item)
+{
+    RBNode<T> *node = new RBNode<T>(item);
+    RBNode<T> *parent = NULL;
+    RBNode<T> *ptr = root;
+    bool isLeftmost = TRUE;	// have we only gone left so far?
+
+    while (ptr != NULL) {
+	parent = ptr;
+	if (compare(item, ptr->item) < 0) {
+	    ptr = ptr->left;
+	} else {
+	    ptr = ptr->right;
+	    isLeftmost = FALSE;
+	}
+    }
+    node->parent = parent;
+    if (parent == NULL) {
+	root = node;
+    } else if (compare(item, parent->item) < 0) {
+	parent->left = node;
+    } else {
+	parent->right = node;
+    }
+    if (isLeftmost) {
+	leftmost = node;
+    }
+    numInTree++;
+    InsertFixup(node);
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::InsertFixup
+//      A red node has just been added.  If its parent is red too,
+//	recolor and rotate until no red node has a red child.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::InsertFixup(RBNode<T> *node)
+{
+    while (node->parent != NULL && node->parent->red) {
+	RBNode<T> *parent = node->parent;
+	RBNode<T> *grandparent = parent->parent;  // exists: root is black
+	RBNode<T> *uncle;
+
+	if (parent == grandparent->left) {
+	    uncle = grandparent->right;
+	    if (uncle != NULL && uncle->red) {
+		parent->red = uncle->red = FALSE;
+		grandparent->red = TRUE;
+		node = grandparent;
+	    } else {
+		if (node == parent->right) {
+		    node = parent;
+		    RotateLeft(node);
+		    parent = node->parent;
+		}
+		parent->red = FALSE;
+		grandparent->red = TRUE;
+		RotateRight(grandparent);
+	    }
+	} else {
+	    uncle = grandparent->left;
+	    if (uncle != NULL && uncle->red) {
+		parent->red = uncle->red = FALSE;
+		grandparent->red = TRUE;
+		node = grandparent;
+	    } else {
+		if (node == parent->left) {
+		    node = parent;
+		    RotateRight(node);
+		    parent = node->parent;
+		}
+		parent->red = FALSE;
+		grandparent->red = TRUE;
+		RotateLeft(grandparent);
+	    }
+	}
+    }
+    root->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Find
+//      Return the node holding "item" in the subtree below "node", or
+//	NULL if there is none.  Items that compare equal to "item" may
+//	be on either side of one another, so look on both sides.
+//----------------------------------------------------------------------
+
+template <class T>
+RBNode<T> *
+RBTree<T>::Find(RBNode<T> *node, T item) const
+{
+    while (node != NULL) {
+	int result = compare(item, node->item);
+
+	if (result < 0) {
+	    node = node->left;
+	} else if (result > 0) {
+	    node = node->right;
+	} else if (node->item == item) {
+	    return node;
+	} else {
+	    RBNode<T> *found = Find(node->left, item);
+
+	    return (found != NULL) ? found : Find(node->right, item);
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RemoveFront
+//      Remove the smallest item from the tree, and return it.
+//	The tree must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+RBTree<T>::RemoveFront()
+{
+    T item;
+
+    ASSERT(!IsEmpty());
+    item = leftmost->item;
+    Remove(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Remove
+//      Remove a specific item from the tree.  Must be in the tree!
+//
+//	If the node holding it has two children, its successor (the
+//	leftmost node on its right) takes its place; otherwise, its
+//	child does.  Either way, if a black node has left the tree, fix
+//	up the black heights.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::Remove(T item)
+{
+    RBNode<T> *node = Find(root, item);
+    RBNode<T> *child, *parent;
+    bool removedRed;
+
+    ASSERT(node != NULL);
+    if (node == leftmost) {	// the next smallest is its right
+				// child's leftmost node, or its parent
+	if (node->right != NULL) {
+	    for (leftmost = node->right; leftmost->left != NULL;
+					leftmost = leftmost->left) {
+		;
+	    }
+	} else {
+	    leftmost = node->parent;
+	}
+    }
+
+    if (node->left == NULL || node->right == NULL) {
+	child = (node->left != NULL) ? node->left : node->right;
+	parent = node->parent;
+	removedRed = node->red;
+	if (child != NULL) {
+	    child->parent = parent;
+	}
+	if (parent == NULL) {
+	    root = child;
+	} else if (node == parent->left) {
+	    parent->left = child;
+	} else {
+	    parent->right = child;
+	}
+    } else {
+	RBNode<T> *next = node->right;	// the successor
+
+	while (next->left != NULL) {
+	    next = next->left;
+	}
+	removedRed = next->red;
+	child = next->right;
+	if (next->parent == node) {
+	    parent = next;
+	} else {
+	    parent = next->parent;
+	    parent->left = child;
+	    if (child != NULL) {
+		child->parent = parent;
+	    }
+	    next->right = node->right;
+	    next->right->parent = next;
+	}
+	next->parent = node->parent;
+	if (node->parent == NULL) {
+	    root = next;
+	} else if (node == node->parent->left) {
+	    node->parent->left = next;
+	} else {
+	    node->parent->right = next;
+	}
+	next->left = node->left;
+	next->left->parent = next;
+	next->red = node->red;
+    }
+    delete node;
+    numInTree--;
+    if (!removedRed) {
+	RemoveFixup(child, parent);
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RemoveFixup
+//      A black node has been removed from above "node" (which may be
+//	NULL, a leaf), so the paths through it are one black node short.
+//	Recolor and rotate until they aren't.
+//
+//	"parent" is the parent of "node", in case "node" is NULL.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::RemoveFixup(RBNode<T> *node, RBNode<T> *parent)
+{
+    while (node != root && (node == NULL || !node->red)) {
+	RBNode<T> *sibling;	// can't be NULL: its side has more
+				// black nodes than ours
+
+	if (node == parent->left) {
+	    sibling = parent->right;
+	    if (sibling->red) {
+		sibling->red = FALSE;
+		parent->red = TRUE;
+		RotateLeft(parent);
+		sibling = parent->right;
+	    }
+	    if ((sibling->left == NULL || !sibling->left->red) &&
+		    (sibling->right == NULL || !sibling->right->red)) {
+		sibling->red = TRUE;
+		node = parent;
+		parent = node->parent;
+	    } else {
+		if (sibling->right == NULL || !sibling->right->red) {
+		    sibling->left->red = FALSE;
+		    sibling->red = TRUE;
+		    RotateRight(sibling);
+		    sibling = parent->right;
+		}
+		sibling->red = parent->red;
+		parent->red = FALSE;
+		sibling->right->red = FALSE;
+		RotateLeft(parent);
+		node = root;
+	    }
+	} else {
+	    sibling = parent->left;
+	    if (sibling->red) {
+		sibling->red = FALSE;
+		parent->red = TRUE;
+		RotateRight(parent);
+		sibling = parent->left;
+	    }
+	    if ((sibling->right == NULL || !sibling->right->red) &&
+		    (sibling->left == NULL || !sibling->left->red)) {
+		sibling->red = TRUE;
+		node = parent;
+		parent = node->parent;
+	    } else {
+		if (sibling->left == NULL || !sibling->left->red) {
+		    sibling->right->red = FALSE;
+		    sibling->red = TRUE;
+		    RotateLeft(sibling);
+		    sibling = parent->left;
+		}
+		sibling->red = parent->red;
+		parent->red = FALSE;
+		sibling->left->red = FALSE;
+		RotateRight(parent);
+		node = root;
+	    }
+	}
+    }
+    if (node != NULL) {
+	node->red = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Apply
+//      Apply function to every item in the tree, smallest first.
+//
+//	"func" is the procedure to apply.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::Apply(void (*func)(T)) const
+{
+    ApplyAll(root, func);
+}
+
+template <class T>
+void
+RBTree<T>::ApplyAll(RBNode<T> *node, void (*func)(T)) const
+{
+    if (node != NULL) {
+	ApplyAll(node->left, func);
+	(*func)(node->item);
+	ApplyAll(node->right, func);
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree::SanityCheck
+//      Test whether this is still a legal red-black tree.
+//
+//	Tests: is the root black?  Is every item in order, with its
+//	links pointing back to its parent?  Does every red node have
+//	black children?  Does every path have the same number of black
+//	nodes?  Are numInTree and leftmost right?
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::SanityCheck() const
+{
+    RBNode<T> *node;
+    int num = 0;
+
+    if (root == NULL) {
+	ASSERT(numInTree == 0 && leftmost == NULL);
+	return;
+    }
+    ASSERT(root->parent == NULL && !root->red);
+    (void) CheckSubtree(root);
+    for (node = root; node->left != NULL; node = node->left) {
+	;
+    }
+    ASSERT(node == leftmost);
+    for (; node != NULL; num++) {	// walk the tree in order
+	RBNode<T> *next;
+
+	if (node->right != NULL) {
+	    for (next = node->right; next->left != NULL; next = next->left) {
+		;
+	    }
+	} else {
+	    for (next = node; next->parent != NULL
+			&& next == next->parent->right; next = next->parent) {
+		;
+	    }
+	    next = next->parent;
+	}
+	ASSERT(next == NULL || compare(node->item, next->item) <= 0);
+	node = next;
+    }
+    ASSERT(num == numInTree);
+}
+
+template <class T>
+int
+RBTree<T>::CheckSubtree(RBNode<T> *node) const
+{
+    int leftHeight, rightHeight;
+
+    if (node == NULL) {
+	return 1;
+    }
+    if (node->left != NULL) {
+	ASSERT(node->left->parent == node);
+	ASSERT(!node->red || !node->left->red);
+    }
+    if (node->right != NULL) {
+	ASSERT(node->right->parent == node);
+	ASSERT(!node->red || !node->right->red);
+    }
+    leftHeight = CheckSubtree(node->left);
+    rightHeight = CheckSubtree(node->right);
+    ASSERT(leftHeight == rightHeight);
+    return leftHeight + (node->red ? 0 : 1);
+}
+
+//----------------------------------------------------------------------
+// RBTree::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::SelfTest(T *p, int numEntries)
+{
+    int i, j;
+    T last, next;
+
+    ASSERT(IsEmpty());
+
+    // put everything in several times, so there are equal items
+    for (j = 0; j < 4; j++) {
+	for (i = 0; i < numEntries; i++) {
+	    Insert(p[i]);
+	    SanityCheck();
+	}
+    }
+    ASSERT(NumInTree() == 4 * numEntries);
+
+    // take one copy of each item back out
+    for (i = 0; i < numEntries; i++) {
+	Remove(p[i]);
+	SanityCheck();
+    }
+
+    // should be able to get out everything else, in the right order
+    last = RemoveFront();
+    while (!IsEmpty()) {
+	next = RemoveFront();
+	ASSERT(compare(last, next) <= 0);
+	last = next;
+	SanityCheck();
+    }
+}
@@ -0,0 +1,113 @@
+// rbtree.h
+//	Data structures to manage a red-black tree -- a binary search
+//	tree that keeps itself balanced, so that inserting or removing
+//	an item takes O(log n) time.
+//
+//	Like a SortedList, a tree gives back its smallest item first,
+//	and items that compare equal come out in the order they were
+//	put in.  Unlike a Heap, any item can be removed in O(log n)
+//	time, and the items can be visited in order.
+//
+//	Allocation and deallocation of the items in the tree are to be
+//	done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "copyright.h"
+#include "debug.h"
+#include "slab.h"
+
+// The following class defines a node of a red-black tree.
+//
+// This class is private to this module. Made public for notational
+// convenience.
+
+template <class T>
+class RBNode {
+  public:
+    RBNode(T itm);		// initialize a red node
+
+    T item;			// item in the tree
+    RBNode *left, *right;	// smaller and bigger items
+    RBNode *parent;		// NULL at the root
+    bool red;			// FALSE if the node is black
+
+    void *operator new(size_t size) { return slab.Alloc(size); }
+    void operator delete(void *p, size_t size) { slab.Free(p, size); }
+    static Slab slab;		// where tree nodes are allocated
+};
+
+// The following class defines a red-black tree.  The rules that keep
+// it balanced are:
+//	1. the root is black
+//	2. a red node has no red children
+//	3. every path from a node down to a leaf goes through the same
+//	   number of black nodes
+// so no path from the root is more than twice as long as any other.
+//
+// All types to be put in a tree must have a "Compare" function
+// defined, as for a SortedList:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+// and a "==" operator, to tell which of several equal items to remove.
+
+template <class T>
+class RBTree {
+  public:
+    RBTree(int (*comp)(T x, T y));// initialize the tree
+    ~RBTree();			// de-allocate the tree
+
+    void Insert(T item);	// put an item into the tree
+
+    T Front() { ASSERT(leftmost != NULL); return leftmost->item; }
+    				// Return smallest item in the tree
+				// without removing it
+    T RemoveFront();		// Take smallest item out of the tree
+    void Remove(T item);	// Remove specific item from the tree
+
+    int NumInTree() { return numInTree; };
+    				// how many items in the tree?
+    bool IsEmpty() { return (numInTree == 0); };
+    				// is the tree empty?
+
+    void Apply(void (*f)(T)) const;
+    				// apply function to all items in the
+				// tree, smallest first
+
+    void SanityCheck() const;	// has this tree been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    int (*compare)(T x, T y);	// function for ordering the items
+    RBNode<T> *root;		// NULL if the tree is empty
+    RBNode<T> *leftmost;	// node with the smallest item
+    int numInTree;		// number of items in the tree
+
+    RBNode<T> *Find(RBNode<T> *node, T item) const;
+				// the node holding "item", below "node"
+    void RotateLeft(RBNode<T> *node);
+    void RotateRight(RBNode<T> *node);
+    void InsertFixup(RBNode<T> *node);
+				// restore the rules after an insert
+    void RemoveFixup(RBNode<T> *node, RBNode<T> *parent);
+				// restore the rules after a remove
+    void DeleteAll(RBNode<T> *node);
+				// free a subtree
+    void ApplyAll(RBNode<T> *node, void (*f)(T)) const;
+				// apply function to a subtree
+    int CheckSubtree(RBNode<T> *node) const;
+				// check a subtree; return its black height
+};
+
+#include "rbtree.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // RBTREE_H
@@ -0,0 +1,125 @@
+// slab.cc
+//	Routines to manage a slab allocator -- a free list of same-sized
+//	objects, carved out of big chunks of memory.
+//
+//	A slab is a static object, so all its fields start out zero.
+//	It learns its object size from the first Alloc call, and only
+//	then goes on the list of slabs in use.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "slab.h"
+
+const int ObjectsPerChunk = 64;	// objects to get from the host at a time
+
+Slab *Slab::allSlabs = NULL;
+
+//----------------------------------------------------------------------
+// Slab::Alloc
+// 	Return memory for an object of "size" bytes -- from the free
+//	list, which is refilled from the host if it is empty.
+//
+//	The first call fixes the size of the slab's objects.  Objects
+//	of any other size are allocated by the host.
+//----------------------------------------------------------------------
+
+void *
+Slab::Alloc(size_t size)
+{
+    SlabObject *object;
+
+    if (objectSize == 0) {
+	// round up, so every object is aligned and can hold a SlabObject
+	objectSize = divRoundUp(max(size, sizeof(SlabObject)),
+				sizeof(double)) * sizeof(double);
+	nextSlab = allSlabs;
+	allSlabs = this;
+    }
+    if (divRoundUp(size, sizeof(double)) * sizeof(double) != objectSize) {
+	numPassedOn++;
+	return ::operator new(size);
+    }
+    if (freeList == NULL) {
+	Grow();
+    }
+    object = freeList;
+    freeList = object->next;
+    numAllocs++;
+    return (void *) object;
+}
+
+//----------------------------------------------------------------------
+// Slab::Free
+// 	Put an object back on the free list, or give it back to the
+//	host if it was allocated there.
+//
+//	"object" -- the object to free
+//	"size" -- its size, as passed to Alloc
+//----------------------------------------------------------------------
+
+void
+Slab::Free(void *object, size_t size)
+{
+    if (object == NULL) {
+	return;
+    }
+    if (divRoundUp(size, sizeof(double)) * sizeof(double) != objectSize) {
+	::operator delete(object);
+	return;
+    }
+    ((SlabObject *) object)->next = freeList;
+    freeList = (SlabObject *) object;
+    numFrees++;
+}
+
+//----------------------------------------------------------------------
+// Slab::Grow
+// 	Get a chunk of memory from the host, and put the objects in it
+//	on the free list.
+//----------------------------------------------------------------------
+
+void
+Slab::Grow()
+{
+    char *chunk = new char[ObjectsPerChunk * objectSize];
+
+    for (int i = ObjectsPerChunk - 1; i >= 0; i--) {
+	SlabObject *object = (SlabObject *) (chunk + i * objectSize);
+
+	object->next = freeList;
+	freeList = object;
+    }
+    numChunks++;
+}
+
+//----------------------------------------------------------------------
+// Slab::Print
+// 	Print how many objects have been allocated from the slab, and
+//	how many times it has had to go to the host for memory.  In the
+//	steady state, the second number should stop growing.
+//----------------------------------------------------------------------
+
+void
+Slab::Print()
+{
+    cout << "Slab " << name << " (" << objectSize << " bytes): ";
+    cout << numAllocs << " allocs, " << numFrees << " frees, ";
+    cout << (numChunks + numPassedOn) << " host allocs\n";
+}
+
+//----------------------------------------------------------------------
+// Slab::PrintAll
+// 	Print every slab that has been used.
+//----------------------------------------------------------------------
+
+void
+Slab::PrintAll()
+{
+    for (Slab *slab = allSlabs; slab != NULL; slab = slab->nextSlab) {
+	slab->Print();
+    }
+}
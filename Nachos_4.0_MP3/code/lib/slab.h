@@ -0,0 +1,75 @@
+// slab.h
+//	Data structures for a simple slab allocator -- a free list of
+//	same-sized objects, carved out of big chunks of memory.
+//
+//	A class that is allocated and freed over and over (a pending
+//	interrupt, a list element, ...) can get its memory from a
+//	Slab, by declaring:
+//
+//	    void *operator new(size_t size) { return slab.Alloc(size); }
+//	    void operator delete(void *p, size_t size) { slab.Free(p, size); }
+//	    static Slab slab;
+//
+//	Freed objects go back on the slab's free list, not to the host,
+//	so once a program has reached its steady state, creating and
+//	deleting these objects does no host memory allocation at all.
+//	The slab counts how often it does have to go to the host, so
+//	that can be checked (see Slab::PrintAll).
+//
+//	A slab holds objects of one size: the size of the first object
+//	allocated from it.  Objects of a bigger subclass are passed
+//	through to the host's allocator.  Chunks are never given back.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "copyright.h"
+#include "utility.h"
+#include <stddef.h>
+
+// Objects on a slab's free list hold a pointer to the next free object.
+class SlabObject {
+  public:
+    SlabObject *next;		// next free object, NULL if this is last
+};
+
+// The following class defines a slab allocator.  Slabs are meant to
+// be static class members; the constructor only records the slab's
+// name, so a slab works even if another static constructor uses it
+// before its own constructor has run.
+
+class Slab {
+  public:
+    Slab(char *debugName) { name = debugName; }
+				// initialize the slab
+
+    void *Alloc(size_t size);	// allocate an object of "size" bytes
+    void Free(void *object, size_t size);
+				// put an object back on the free list
+
+    void Print();		// print how the slab has been used
+    static void PrintAll();	// print every slab that has been used
+
+  private:
+    char *name;			// useful for debugging
+    size_t objectSize;		// size of each object, 0 until first use
+    SlabObject *freeList;	// objects ready to be allocated
+    int numAllocs;		// objects allocated from the slab
+    int numFrees;		// objects put back
+    int numChunks;		// chunks allocated from the host
+    int numPassedOn;		// objects of the wrong size, allocated
+				// from the host
+    Slab *nextSlab;		// next slab that has been used
+
+    void Grow(); 		// put another chunk on the free list
+
+    static Slab *allSlabs;	// every slab that has been used
+};
+
+#endif // SLAB_H
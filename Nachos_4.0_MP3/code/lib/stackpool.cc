@@ -0,0 +1,141 @@
+// stackpool.cc
+//	Routines to manage a pool of thread execution stacks, each
+//	bounded by guard pages.
+//
+//	The stacks are allocated and de-allocated by AllocBoundedArray
+//	and DeallocBoundedArray; the pool only decides when to call them.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "sysdep.h"
+#include "stackpool.h"
+
+//----------------------------------------------------------------------
+// StackPool::StackPool
+// 	Initialize an empty pool of stacks.
+//
+//	"maxFree" -- the most free stacks to keep for reuse
+//----------------------------------------------------------------------
+
+StackPool::StackPool(int maxFree)
+{
+    ASSERT(maxFree >= 0);
+    this->maxFree = maxFree;
+    sizes = NULL;
+    numFree = 0;
+    numHits = numMisses = numReleased = 0;
+}
+
+//----------------------------------------------------------------------
+// StackPool::~StackPool
+// 	Give every free stack back to the host, and de-allocate the pool.
+//	Stacks still in use are the caller's problem.
+//----------------------------------------------------------------------
+
+StackPool::~StackPool()
+{
+    while (sizes != NULL) {
+	StackSizeClass *sizeClass = sizes;
+
+	while (sizeClass->freeList != NULL) {
+	    FreeStack *stack = sizeClass->freeList;
+
+	    sizeClass->freeList = stack->next;
+	    DeallocBoundedArray((char *) stack, sizeClass->size);
+	}
+	sizes = sizeClass->next;
+	delete sizeClass;
+    }
+}
+
+//----------------------------------------------------------------------
+// StackPool::FindSize
+// 	Return the free stacks of "size" bytes, starting an empty list
+//	of them if this is the first time we've seen that size.
+//----------------------------------------------------------------------
+
+StackSizeClass *
+StackPool::FindSize(int size)
+{
+    StackSizeClass *sizeClass;
+
+    for (sizeClass = sizes; sizeClass != NULL; sizeClass = sizeClass->next) {
+	if (sizeClass->size == size) {
+	    return sizeClass;
+	}
+    }
+    sizeClass = new StackSizeClass;
+    sizeClass->size = size;
+    sizeClass->freeList = NULL;
+    sizeClass->next = sizes;
+    sizes = sizeClass;
+    return sizeClass;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Alloc
+// 	Return a stack of "size" bytes, bounded by guard pages -- one
+//	left by a thread that has finished, if there is one, otherwise
+//	a new one from the host.
+//----------------------------------------------------------------------
+
+char *
+StackPool::Alloc(int size)
+{
+    StackSizeClass *sizeClass = FindSize(size);
+    FreeStack *stack = sizeClass->freeList;
+
+    if (stack == NULL) {
+	numMisses++;
+	return AllocBoundedArray(size);
+    }
+    sizeClass->freeList = stack->next;
+    numFree--;
+    numHits++;
+    return (char *) stack;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Free
+// 	Keep a stack, with its guard pages, for the next thread that
+//	needs one of the same size -- or, if the pool is full, give it
+//	back to the host.
+//
+//	"stack" -- the stack, as returned by Alloc
+//	"size" -- its size, as passed to Alloc
+//----------------------------------------------------------------------
+
+void
+StackPool::Free(char *stack, int size)
+{
+    StackSizeClass *sizeClass;
+
+    if (numFree == maxFree) {
+	numReleased++;
+	DeallocBoundedArray(stack, size);
+	return;
+    }
+    sizeClass = FindSize(size);
+    ((FreeStack *) stack)->next = sizeClass->freeList;
+    sizeClass->freeList = (FreeStack *) stack;
+    numFree++;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Print
+// 	Print how many stacks could be reused, and how many had to be
+//	allocated from the host, and given back to it.  A kernel that
+//	keeps forking threads should mostly hit.
+//----------------------------------------------------------------------
+
+void
+StackPool::Print()
+{
+    cout << "Stack pool (at most " << maxFree << " free): ";
+    cout << numHits << " hits, " << numMisses << " misses, ";
+    cout << numReleased << " released\n";
+}
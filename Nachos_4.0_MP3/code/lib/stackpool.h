@@ -0,0 +1,70 @@
+// stackpool.h
+//	Data structures for a pool of thread execution stacks.
+//
+//	Each stack is bounded by guard pages (see AllocBoundedArray), so
+//	that running off either end of it causes an error.  Setting up
+//	and tearing down the guard pages takes system calls, so rather
+//	than giving the stack of a finished thread back to the host, we
+//	keep it, guard pages still in place, for the next thread that
+//	needs a stack of that size.  A kernel that forks many short-lived
+//	threads then only goes to the host until the pool has filled up.
+//
+//	The pool holds at most a fixed number of free stacks, of any mix
+//	of sizes; beyond that, freed stacks go back to the host.  It
+//	counts how often a stack could be reused, so that can be checked
+//	(see StackPool::Print).
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef STACKPOOL_H
+#define STACKPOOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// A free stack holds a pointer to the next free stack of the same size,
+// in its first word.
+class FreeStack {
+  public:
+    FreeStack *next;		// next free stack, NULL if this is last
+};
+
+// The free stacks of one size.
+class StackSizeClass {
+  public:
+    int size;			// size of the stacks, in bytes
+    FreeStack *freeList;	// stacks ready to be reused
+    StackSizeClass *next;	// the next size that has been used
+};
+
+// The following class defines a pool of thread stacks.
+
+class StackPool {
+  public:
+    StackPool(int maxFree);	// initialize the pool, to keep at most
+				// "maxFree" stacks; 0 keeps none
+    ~StackPool();		// give every free stack back to the host
+
+    char *Alloc(int size);	// return a stack of "size" bytes
+    void Free(char *stack, int size);
+				// put a stack back in the pool
+
+    void Print();		// print how the pool has been used
+
+  private:
+    StackSizeClass *sizes;	// the sizes that have been used
+    int maxFree;		// most free stacks to keep
+    int numFree;		// free stacks kept, of every size
+    int numHits;		// stacks reused from the pool
+    int numMisses;		// stacks allocated from the host
+    int numReleased;		// stacks given back, the pool being full
+
+    StackSizeClass *FindSize(int size);
+				// the free stacks of "size" bytes
+};
+
+#endif // STACKPOOL_H
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/file.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -40,9 +41,6 @@
 #include <fcntl.h>
 #endif
 
-#ifdef LINUX	 // at this point, linux doesn't support mprotect 
-#define NO_MPROT     
-#endif
 #ifdef DOS	// neither does DOS
 #define NO_MPROT
 #endif
@@ -70,7 +68,7 @@ unsigned sleep(unsigned);
 //#endif
 
 
-#ifndef NO_MPROT	
+#if !defined(NO_MPROT) && !defined(LINUX)	// declared in sys/mman.h
 
 #ifdef OSF
 #define OSF_OR_AIX
@@ -149,6 +147,19 @@ UDelay(unsigned int useconds)
 
 }
 
+//----------------------------------------------------------------------
+// HostCPUTime
+// 	Return the number of seconds of CPU time the UNIX process running
+//	Nachos has used so far.  Used to measure how fast the simulator
+//	itself runs.
+//----------------------------------------------------------------------
+
+double
+HostCPUTime()
+{
+    return (double) clock() / CLOCKS_PER_SEC;
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
@@ -203,6 +214,10 @@ RandomNumber()
 //
 //	Note: Just return the useful part!
 //
+//	mprotect only works on whole pages, so the array starts on a
+//	page boundary, just after the first unmapped page, and its size
+//	is rounded up to whole pages.
+//
 //	"size" -- amount of useful space needed (in bytes)
 //----------------------------------------------------------------------
 
@@ -213,10 +228,17 @@ AllocBoundedArray(int size)
     return new char[size];
 #else
     int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
+    int arraySize = divRoundUp(size, pgSize) * pgSize;
+    void *mem;
+    char *ptr;
 
+    if (posix_memalign(&mem, pgSize, pgSize * 2 + arraySize) != 0) {
+	cerr << "Can't allocate " << size << " bytes\n";
+	Abort();
+    }
+    ptr = (char *) mem;
     mprotect(ptr, pgSize, 0);
-    mprotect(ptr + pgSize + size, pgSize, 0);
+    mprotect(ptr + pgSize + arraySize, pgSize, 0);
     return ptr + pgSize;
 #endif
 }
@@ -240,13 +262,52 @@ void
 DeallocBoundedArray(char *ptr, int size)
 {
     int pgSize = getpagesize();
+    int arraySize = divRoundUp(size, pgSize) * pgSize;
 
     mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    delete [] (ptr - pgSize);
+    mprotect(ptr + arraySize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
+    free(ptr - pgSize);
 }
 #endif
 
+//----------------------------------------------------------------------
+// AllocCodeArray
+// 	Return memory that host machine code can be written into, and
+//	then run from (see machine/mipsx86.cc), or NULL if the host
+//	doesn't allow that.
+//
+//	"size" -- amount of space needed (in bytes)
+//----------------------------------------------------------------------
+
+char *
+AllocCodeArray(int size)
+{
+#ifdef NO_MPROT
+    return NULL;
+#else
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+		     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    return (mem == MAP_FAILED) ? NULL : (char *) mem;
+#endif
+}
+
+//----------------------------------------------------------------------
+// DeallocCodeArray
+// 	Deallocate memory returned by AllocCodeArray.
+//
+//	"ptr" -- the memory to be deallocated
+//	"size" -- its size (in bytes)
+//----------------------------------------------------------------------
+
+void
+DeallocCodeArray(char *ptr, int size)
+{
+#ifndef NO_MPROT
+    munmap(ptr, size);
+#endif
+}
+
 //----------------------------------------------------------------------
 // PollFile
 // 	Check open file or open socket to see if there are any 
@@ -296,6 +357,44 @@ PollFile(int fd)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// WaitForFile
+// 	Like PollFile, but if there are no characters on the file, wait
+//	up to "msec" milliseconds for some to arrive.  Return TRUE if 
+//	there are characters that can be read immediately.
+//
+//	"fd" -- the file descriptor of the file to wait for
+//	"msec" -- how long to wait, at most
+//----------------------------------------------------------------------
+
+bool
+WaitForFile(int fd, int msec)
+{
+#if defined(SOLARIS) || defined(LINUX)
+    fd_set rfd;
+#else
+    int rfd = (1 << fd);
+#endif
+    int retVal;
+    struct timeval waitTime;
+
+#if defined(SOLARIS) || defined(LINUX)
+    FD_ZERO(&rfd);
+    FD_SET(fd, &rfd);
+#endif
+    waitTime.tv_sec = msec / 1000;
+    waitTime.tv_usec = (msec % 1000) * 1000;
+
+#if defined(BSD)
+    retVal = select(32, (fd_set*)&rfd, NULL, NULL, &waitTime);
+#else
+    retVal = select(32, &rfd, NULL, NULL, &waitTime);
+#endif
+
+    return (retVal == 1);	// 0 if we timed out, -1 if interrupted
+				// by a signal
+}
+
 //----------------------------------------------------------------------
 // OpenForWrite
 // 	Open a file for writing.  Create it if it doesn't exist; truncate it 
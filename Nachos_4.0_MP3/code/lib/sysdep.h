@@ -24,6 +24,7 @@ extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
 extern void UDelay(unsigned int usec);// rcgood - to avoid spinners.
+extern double HostCPUTime();	// seconds of host CPU used so far
 
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(void (*cleanup)(int));
@@ -37,10 +38,19 @@ extern unsigned int RandomNumber();
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
 
+// Allocate, de-allocate memory that can hold host machine code, to be
+// run; AllocCodeArray returns NULL if the host won't allow it
+extern char *AllocCodeArray(int size);
+extern void DeallocCodeArray(char *p, int size);
+
 // Check file to see if there are any characters to be read.
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
 
+// Check file to see if there are any characters to be read.
+// If no characters in the file, wait a while for some.
+extern bool WaitForFile(int fd, int msec);
+
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
 extern int OpenForWrite(char *name);
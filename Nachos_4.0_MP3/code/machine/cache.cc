@@ -0,0 +1,96 @@
+// cache.cc
+//	Routines to emulate a set-associative memory cache.
+//
+//	See cache.h: only the tags are kept, to decide which accesses
+//	hit and which miss.  The cache is indexed and tagged by physical
+//	address.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "cache.h"
+
+//----------------------------------------------------------------------
+// Cache::Cache
+// 	Initialize an empty cache.
+//
+//	"size" -- total bytes of data the cache holds
+//	"lineSize" -- bytes per line (a power of two)
+//	"ways" -- lines per set (1 for direct mapped, size/lineSize for
+//		fully associative)
+//	"missPenalty" -- extra ticks taken by an access that misses
+//	"hitCount", "missCount" -- counters to increment on each hit, miss
+//----------------------------------------------------------------------
+
+Cache::Cache(int size, int lineSize, int ways, int missPenalty,
+	     int *hitCount, int *missCount)
+{
+    ASSERT(lineSize >= 4 && (lineSize & (lineSize - 1)) == 0);
+    ASSERT(ways > 0 && size > 0 && size % (lineSize * ways) == 0);
+    ASSERT(missPenalty >= 0);
+
+    for (lineShift = 0; (1 << lineShift) < lineSize; lineShift++)
+	;
+    numWays = ways;
+    numSets = size / (lineSize * ways);
+    penalty = missPenalty;
+    hits = hitCount;
+    misses = missCount;
+
+    tags = new int[numSets * numWays];
+    lastUse = new int[numSets * numWays];
+    for (int i = 0; i < numSets * numWays; i++) {
+	tags[i] = -1;
+	lastUse[i] = 0;
+    }
+    useClock = 0;
+}
+
+//----------------------------------------------------------------------
+// Cache::~Cache
+// 	De-allocate the cache's tags.
+//----------------------------------------------------------------------
+
+Cache::~Cache()
+{
+    delete [] tags;
+    delete [] lastUse;
+}
+
+//----------------------------------------------------------------------
+// Cache::Access
+// 	Simulate an access to physical address "physAddr".  If the line
+//	holding it is not in its set, replace the least recently used
+//	line of the set with it.
+//
+//	Returns the number of ticks the access takes beyond a hit: 0, or
+//	the miss penalty.
+//----------------------------------------------------------------------
+
+int
+Cache::Access(int physAddr)
+{
+    int line = physAddr >> lineShift;
+    int first = (line % numSets) * numWays;
+    int victim = first;
+
+    useClock++;
+    for (int i = first; i < first + numWays; i++) {
+	if (tags[i] == line) {
+	    lastUse[i] = useClock;
+	    (*hits)++;
+	    return 0;
+	}
+	if (lastUse[i] < lastUse[victim])
+	    victim = i;
+    }
+    tags[victim] = line;
+    lastUse[victim] = useClock;
+    (*misses)++;
+    return penalty;
+}
@@ -0,0 +1,57 @@
+// cache.h
+//	Data structures to emulate a set-associative memory cache, such
+//	as the level 1 instruction and data caches of the MIPS CPU.
+//
+//	Only the tags are simulated, not the data: the cache decides
+//	whether an access to physical memory would hit or miss, and so
+//	how long it would take, but the data always comes from
+//	mainMemory.  Thus the kernel can still read and write mainMemory
+//	directly, without flushing anything.
+//
+//	Each set is replaced least recently used first.  Writes are
+//	treated like reads (write-allocate, with no charge for writing
+//	lines back).
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines a cache in front of physical memory.
+class Cache {
+  public:
+    Cache(int size, int lineSize, int ways, int missPenalty,
+	  int *hitCount, int *missCount);
+				// Initialize an empty cache of "size" bytes,
+				// with "ways" lines of "lineSize" bytes per
+				// set.  A miss costs "missPenalty" extra
+				// ticks; hits and misses are counted in
+				// "*hitCount" and "*missCount"
+    ~Cache();
+
+    int Access(int physAddr);	// Look up the line holding physAddr,
+				// loading it on a miss; return the extra
+				// ticks the access takes
+
+  private:
+    int lineShift;		// log2(lineSize)
+    int numSets;		// number of sets
+    int numWays;		// lines per set
+    int penalty;		// extra ticks for a miss
+    int *hits;			// where to count hits
+    int *misses;		// and misses
+
+    int *tags;			// line # held by each line of each set
+				// (set * numWays + way), or -1 if empty
+    int *lastUse;		// when each line was last used, for LRU
+    int useClock;		// counts accesses, for lastUse
+};
+
+#endif // CACHE_H
@@ -23,9 +23,13 @@
 //	"readFile" -- UNIX file simulating the keyboard (NULL -> use stdin)
 // 	"toCall" is the interrupt handler to call when a character arrives
 //		from the keyboard
+//	"hostWait" -- if TRUE, when the machine is idle with nothing but
+//		input to wait for, give the host a while to deliver a 
+//		keystroke between polls, instead of spinning
 //----------------------------------------------------------------------
 
-ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
+ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall, 
+			   bool hostWait)
 {
     if (readFile == NULL)
 	readFileNo = 0;					// keyboard = stdin
@@ -35,9 +39,28 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
     incoming = EOF;
+    polling = FALSE;
+    waitOnHost = hostWait;
 
-    // start polling for incoming keystrokes
-    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    // keystrokes are only polled for once someone wants to read one
+    // (see StartPolling), so an idle machine doesn't keep interrupting
+    // itself to look for input nobody is waiting for
+}
+
+//----------------------------------------------------------------------
+// ConsoleInput::StartPolling()
+// 	The OS wants the next character from the keyboard.  Start 
+//	polling for it, unless we already are; "callWhenAvail" will be
+//	called when it arrives.
+//----------------------------------------------------------------------
+
+void
+ConsoleInput::StartPolling()
+{
+    if (!polling && incoming == EOF) {
+	polling = TRUE;
+	kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -59,6 +82,12 @@ ConsoleInput::~ConsoleInput()
 //
 //	First check to make sure character is available.
 //	Then invoke the "callBack" registered by whoever wants the character.
+//
+//	If there's no character, but the machine is idle and the only 
+//	interrupts to come are polls for input, nothing can happen in 
+//	the simulation until a key is hit (or a packet arrives).  If 
+//	"waitOnHost" is set, rather than polling again straight away, 
+//	give the host a while to deliver some input.
 //----------------------------------------------------------------------
 
 void
@@ -68,9 +97,14 @@ ConsoleInput::CallBack()
   int readCount;
 
     ASSERT(incoming == EOF);
+    polling = FALSE;
+    if (waitOnHost && kernel->interrupt->getStatus() == IdleMode
+		&& kernel->interrupt->OnlyInputPending()) {
+	(void) WaitForFile(readFileNo, ConsoleWaitTime);
+    }
     if (!PollFile(readFileNo)) { // nothing to be read
         // schedule the next time to poll for a packet
-        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+        StartPolling();
     } else { 
     	// otherwise, try to read a character
     	readCount = ReadPartial(readFileNo, &c, sizeof(char));
@@ -96,6 +130,9 @@ ConsoleInput::CallBack()
 // ConsoleInput::GetChar()
 // 	Read a character from the input buffer, if there is any there.
 //	Either return the character, or EOF if none buffered.
+//
+//	The next character isn't looked for until StartPolling is
+//	called again.
 //----------------------------------------------------------------------
 
 char
@@ -103,9 +140,6 @@ ConsoleInput::GetChar()
 {
    char ch = incoming;
 
-   if (incoming != EOF) {	// schedule when next char will arrive
-       kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
-   }
    incoming = EOF;
    return ch;
 }
@@ -31,6 +31,10 @@
 #include "utility.h"
 #include "callback.h"
 
+const int ConsoleWaitTime = 100;	// milliseconds to wait on the host
+					// for a keystroke, when that's all
+					// there is to do (see ConsoleInput)
+
 // The following two classes define the input (and output) side of a 
 // hardware console device.  Input (and output) to the device is simulated 
 // by reading (and writing) to the UNIX file "readFile" (and "writeFile").
@@ -46,7 +50,7 @@
 
 class ConsoleInput : public CallBackObj {
   public:
-    ConsoleInput(char *readFile, CallBackObj *toCall);
+    ConsoleInput(char *readFile, CallBackObj *toCall, bool hostWait);
 				// initialize hardware console input 
     ~ConsoleInput();		// clean up console emulation
 
@@ -54,6 +58,8 @@ class ConsoleInput : public CallBackObj {
 				// available, return it.  Otherwise, return EOF.
     				// "callWhenAvail" is called whenever there is 
 				// a char to be gotten
+    void StartPolling();	// Look for a char to arrive.  Only
+				// then is "callWhenAvail" called.
 
     void CallBack();		// Invoked when a character arrives
 				// from the keyboard.
@@ -65,6 +71,10 @@ class ConsoleInput : public CallBackObj {
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
+    bool polling;			// Is a poll for input scheduled?
+    bool waitOnHost;			// Rather than poll over and over
+					// while nothing else can happen, wait
+					// for a keystroke on the host?
 };
 
 class ConsoleOutput : public CallBackObj {
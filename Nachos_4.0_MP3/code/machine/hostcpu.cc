@@ -0,0 +1,134 @@
+// hostcpu.cc
+//	Routines to run one CPU of a multiprocessor on a host thread.
+//
+//	See hostcpu.h.  The kernel's host thread and a HostCPU's take
+//	turns: the kernel loads the machine and calls Start, the host
+//	thread runs it, and the kernel doesn't look at the machine again
+//	until Wait returns.  The lock hands the machine over in both
+//	directions.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "hostcpu.h"
+
+//----------------------------------------------------------------------
+// HostCPU::HostCPU
+// 	Initialize a CPU, and start the host thread that runs it.  The
+//	host thread waits to be told to run.
+//
+//	"cpuID" -- which CPU this is
+//	"firstCPU" -- the machine the kernel runs on
+//----------------------------------------------------------------------
+
+HostCPU::HostCPU(int cpuID, Machine *firstCPU)
+{
+    id = cpuID;
+    stats = new Statistics();
+    machine = new Machine(firstCPU, stats);
+    state = Waiting;
+    runUntil = 0;
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&changed, NULL);
+    if (pthread_create(&hostThread, NULL, HostThreadRoot, this) != 0) {
+	cerr << "Can't start a host thread for CPU " << id << "\n";
+	Abort();
+    }
+}
+
+//----------------------------------------------------------------------
+// HostCPU::~HostCPU
+// 	Tell the host thread to quit, wait for it, and de-allocate the
+//	CPU.  The CPU must not be running.
+//----------------------------------------------------------------------
+
+HostCPU::~HostCPU()
+{
+    pthread_mutex_lock(&lock);
+    ASSERT(state == Waiting);
+    state = Quitting;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+    pthread_join(hostThread, NULL);
+    pthread_cond_destroy(&changed);
+    pthread_mutex_destroy(&lock);
+    delete machine;
+    delete stats;
+}
+
+//----------------------------------------------------------------------
+// HostCPU::Start
+// 	Have the host thread run the user program loaded into the
+//	machine, until the clock (stats->totalTicks) reaches "until", or
+//	the program needs the kernel.  Returns at once; call Wait before
+//	looking at the machine again.
+//----------------------------------------------------------------------
+
+void
+HostCPU::Start(int until)
+{
+    pthread_mutex_lock(&lock);
+    ASSERT(state == Waiting);
+    runUntil = until;
+    state = Running;
+    pthread_cond_broadcast(&changed);
+    pthread_mutex_unlock(&lock);
+}
+
+//----------------------------------------------------------------------
+// HostCPU::Wait
+// 	Wait until the host thread has stopped running the machine.
+//----------------------------------------------------------------------
+
+void
+HostCPU::Wait()
+{
+    pthread_mutex_lock(&lock);
+    while (state == Running) {
+	pthread_cond_wait(&changed, &lock);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+//----------------------------------------------------------------------
+// HostCPU::HostThreadRoot
+// 	Where the host thread starts: run the CPU's main loop.
+//----------------------------------------------------------------------
+
+void *
+HostCPU::HostThreadRoot(void *arg)
+{
+    ((HostCPU *) arg)->Work();
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// HostCPU::Work
+// 	The host thread's main loop: each time Start is called, run the
+//	machine, then say it's done, until the CPU is de-allocated.
+//----------------------------------------------------------------------
+
+void
+HostCPU::Work()
+{
+    pthread_mutex_lock(&lock);
+    for (;;) {
+	while (state == Waiting) {
+	    pthread_cond_wait(&changed, &lock);
+	}
+	if (state == Quitting) {
+	    break;
+	}
+	pthread_mutex_unlock(&lock);
+	machine->RunAhead(runUntil);
+	pthread_mutex_lock(&lock);
+	state = Waiting;
+	pthread_cond_broadcast(&changed);
+    }
+    pthread_mutex_unlock(&lock);
+}
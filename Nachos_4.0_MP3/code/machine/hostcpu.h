@@ -0,0 +1,63 @@
+// hostcpu.h
+//	Data structures to run one CPU of a multiprocessor on a host
+//	thread of its own, so that several CPUs can run user programs
+//	at the same time, on several host cores (see "nachos -parallel").
+//
+//	Each HostCPU has a Machine of its own -- registers, soft TLB and
+//	clock -- which shares main memory with the kernel's machine.  The
+//	kernel still runs on one host thread, and only ever on its own
+//	machine: a HostCPU only runs user instructions (Machine::RunAhead),
+//	up to a time the kernel gives it, and stops at the first
+//	instruction that needs the kernel, leaving it to be run again.
+//
+//	Nachos user programs don't share memory, so as long as no device
+//	interrupt is due, what one does can't affect another, and they
+//	can run in any order -- or at once.
+//
+//  DO NOT CHANGE -- part of the machine emulation
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HOSTCPU_H
+#define HOSTCPU_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "machine.h"
+#include "stats.h"
+#include <pthread.h>
+
+// The following class defines a simulated CPU, and the host thread
+// that runs it.
+class HostCPU {
+  public:
+    HostCPU(int cpuID, Machine *firstCPU);
+				// Start a host thread for CPU "cpuID",
+				// sharing memory with "firstCPU"
+    ~HostCPU();			// Stop the host thread
+
+    Machine *machine;		// the CPU: load a user program's registers
+				// and page table here before Start
+    Statistics *stats;		// its clock, and how many user ticks and
+				// instructions it has run
+
+    void Start(int until);	// Have the host thread run the CPU, until
+				// its clock reaches "until"
+    void Wait();		// Wait until it has stopped
+
+  private:
+    int id;			// which CPU this is, for debugging
+    pthread_t hostThread;	// the host thread, which waits for Start
+    pthread_mutex_t lock;	// protects the fields below
+    pthread_cond_t changed;	// signalled when "state" changes
+    enum { Waiting, Running, Quitting } state;
+    int runUntil;		// the "until" given to Start
+
+    static void *HostThreadRoot(void *arg);
+				// where the host thread starts
+    void Work();		// its main loop
+};
+
+#endif // HOSTCPU_H
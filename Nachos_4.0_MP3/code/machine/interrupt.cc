@@ -22,6 +22,7 @@
 
 #include "copyright.h"
 #include "interrupt.h"
+#include <limits.h>
 #include "main.h"
 #include "kernel.h"
 #include "synchconsole.h"
@@ -32,6 +33,8 @@ static char *intTypeNames[] = { "timer", "disk", "console write",
 			"console read", "network send", 
 			"network recv"};
 
+Slab PendingInterrupt::slab("pending interrupt");
+
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
 // 	Initialize a hardware device interrupt that is to be scheduled 
@@ -73,9 +76,10 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new Heap<PendingInterrupt *>(PendingCompare);
     inHandler = FALSE;
     yieldOnReturn = FALSE;
+    userYield = FALSE;
     status = SystemMode;
 }
 
@@ -170,6 +174,7 @@ Interrupt::OneTick()
     if (yieldOnReturn) {	// if the timer device handler asked 
     				// for a context switch, ok to do it now
 	yieldOnReturn = FALSE;
+	userYield = (oldStatus == UserMode);
  	status = SystemMode;		// yield is a kernel routine
 	//cout << "yieldOnReturn!!!!!!!!!!!" << endl;
 	kernel->currentThread->Yield();
@@ -177,6 +182,77 @@ Interrupt::OneTick()
     }
 }
 
+//----------------------------------------------------------------------
+// Interrupt::Horizon
+// 	Return the simulated time at which the earliest pending interrupt
+//	is due, or INT_MAX if nothing is pending.
+//
+//	As long as totalTicks stays below this time, a call to OneTick
+//	only advances the clock, so the machine simulation can execute
+//	user instructions up to the horizon and account for their ticks
+//	in one go (see Machine::AdvanceClock).  Anything that schedules
+//	or moves an interrupt may change the horizon, so it must be
+//	re-read after returning from the kernel.
+//----------------------------------------------------------------------
+
+int
+Interrupt::Horizon()
+{
+    if (pending->IsEmpty()) {
+	return INT_MAX;
+    }
+    return pending->Front()->when;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::OnlyInputPending
+// 	Return TRUE if every pending interrupt is a poll for input from
+//	the outside world -- the console or the network.  If the machine
+//	is idle too, nothing can happen but wait for some input.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::OnlyInputPending()
+{
+    for (int i = 0; i < pending->NumInHeap(); i++) {
+	IntType type = pending->Item(i)->type;
+
+	if (type != ConsoleReadInt && type != NetworkRecvInt) {
+	    return FALSE;
+	}
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::DeviceHorizon
+// 	Return when the earliest pending interrupt is due that a CPU of
+//	a multiprocessor must not run past, while it runs user code on
+//	its own (see Scheduler::RunAhead); or INT_MAX if there is none.
+//
+//	That's every interrupt but two kinds.  The timer just ends the
+//	CPU's turn, so it's up to the scheduler how long a turn is.  And
+//	a poll for console or network input only looks at the outside
+//	world, whose timing isn't simulated anyway: a poll that comes a
+//	little late can't tell.
+//----------------------------------------------------------------------
+
+int
+Interrupt::DeviceHorizon()
+{
+    int horizon = INT_MAX;
+
+    for (int i = 0; i < pending->NumInHeap(); i++) {
+	PendingInterrupt *next = pending->Item(i);
+
+	if (next->type != TimerInt && next->type != ConsoleReadInt
+		&& next->type != NetworkRecvInt && next->when < horizon) {
+	    horizon = next->when;
+	}
+    }
+    return horizon;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::YieldOnReturn
 // 	Called from within an interrupt handler, to cause a context switch
@@ -195,6 +271,25 @@ Interrupt::YieldOnReturn()
     yieldOnReturn = TRUE; 
 }
 
+//----------------------------------------------------------------------
+// Interrupt::YieldingFromUser
+// 	Return TRUE if the current thread is yielding because of
+//	YieldOnReturn, and was interrupted between two user instructions
+//	-- so its user registers are all there is to its state.  Only
+//	the first call says so: the scheduler asks as the thread gives
+//	up the CPU (see Scheduler::NextCPU), and by the time anyone asks
+//	again, some other thread may be running.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::YieldingFromUser()
+{
+    bool yielding = userYield;
+
+    userYield = FALSE;
+    return yielding;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Idle
 // 	Routine called when there is nothing in the ready queue.
@@ -293,7 +388,9 @@ Interrupt::CloseFile(OpenFileId id)
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: just put it in a heap, ordered by when it is
+//	to occur.  Interrupts due at the same time occur in the order
+//	they were scheduled.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -349,6 +446,8 @@ Interrupt::CheckIfDue(bool advanceClock)
         }
         else {      		// advance the clock to next interrupt
 	    stats->idleTicks += (next->when - stats->totalTicks);
+	    stats->cpuIdleTicks[stats->currentCPU] += 
+			(next->when - stats->totalTicks);
 	    stats->totalTicks = next->when;
 	    // UDelay(1000L); // rcgood - to stop nachos from spinning.
 	}
@@ -397,25 +496,148 @@ Interrupt::DumpState()
     cout << "Time: " << kernel->stats->totalTicks;
     cout << ", interrupts " << intLevelNames[level] << "\n";
     cout << "Pending interrupts:\n";
-    pending->Apply(PrintPending);
+    pending->Apply(PrintPending);	// in no particular order
     cout << "\nEnd of pending interrupts\n";
 }
 
+//----------------------------------------------------------------------
+// IntBenchmark
+//	A fake hardware device, for Interrupt::SelfTest.  Each time
+//	its interrupt occurs, it checks that interrupts are occurring
+//	in order, and schedules another one a random time later, until
+//	it has been interrupted "numFires" times.
+//----------------------------------------------------------------------
+
+const int MaxBenchmarkDelay = 100;	// ticks between a device's
+					// interrupts, at most
+
+class IntBenchmark : public CallBackObj {
+  public:
+    void Start(IntType kind, int numFires);
+				// schedule the device's first interrupt
+    void CallBack();		// called when the interrupt occurs
+
+    static int numFired;	// interrupts fired so far, all devices
+    static int lastWhen;	// when the last one was due
+    static unsigned int lastOrder; // and when it was scheduled
+    static unsigned int numScheduled; // interrupts scheduled so far
+
+  private:
+    void ScheduleNext();	// schedule the next interrupt
+
+    IntType type;		// the device we are pretending to be
+    int firesLeft;		// interrupts still to be scheduled
+    int when;			// when the pending one is due
+    unsigned int order;		// and how many were scheduled before it
+};
+
+int IntBenchmark::numFired;
+int IntBenchmark::lastWhen;
+unsigned int IntBenchmark::lastOrder;
+unsigned int IntBenchmark::numScheduled;
+
+void
+IntBenchmark::Start(IntType kind, int numFires)
+{
+    type = kind;
+    firesLeft = numFires;
+    ScheduleNext();
+}
+
+void
+IntBenchmark::ScheduleNext()
+{
+    int fromNow = 1 + RandomNumber() % MaxBenchmarkDelay;
+
+    when = kernel->stats->totalTicks + fromNow;
+    order = numScheduled++;
+    firesLeft--;
+    kernel->interrupt->Schedule(this, fromNow, type);
+}
+
+void
+IntBenchmark::CallBack()
+{
+    // earliest first; the first scheduled first, if due at the same time
+    ASSERT(when == kernel->stats->totalTicks);
+    ASSERT(numFired == 0 || when > lastWhen
+		|| (when == lastWhen && (int) (order - lastOrder) > 0));
+    lastWhen = when;
+    lastOrder = order;
+    numFired++;
+    if (firesLeft > 0) {
+	ScheduleNext();
+    }
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SelfTest
+// 	Check that interrupts occur in order, and time how long the
+//	simulation takes to schedule and fire them, with "numEvents"
+//	devices each interrupting repeatedly -- as many timer, disk,
+//	console and network devices as each other.
+//
+//	Simulated time advances as if the machine were idle, and any
+//	real device interrupts that come due occur as usual.
+//----------------------------------------------------------------------
+
+void
+Interrupt::SelfTest(int numEvents)
+{
+    const int FiresPerDevice = 10;
+    static IntType kinds[] = { TimerInt, DiskInt, ConsoleWriteInt,
+			ConsoleReadInt, NetworkSendInt, NetworkRecvInt };
+    int numKinds = sizeof(kinds) / sizeof(IntType);
+    IntBenchmark *devices = new IntBenchmark[numEvents];
+    IntStatus oldLevel = SetLevel(IntOff);
+    MachineStatus oldStatus = status;
+    double start, elapsed;
+    int numInterrupts = numEvents * FiresPerDevice;
+
+    status = IdleMode;		// so the timer doesn't ask to time slice
+    IntBenchmark::numFired = 0;
+    IntBenchmark::numScheduled = 0;
+
+    start = HostCPUTime();
+    for (int i = 0; i < numEvents; i++) {
+	devices[i].Start(kinds[i % numKinds], FiresPerDevice);
+    }
+    while (IntBenchmark::numFired < numInterrupts) {
+	CheckIfDue(TRUE);
+    }
+    elapsed = HostCPUTime() - start;
+
+    status = oldStatus;
+    (void) SetLevel(oldLevel);
+    delete [] devices;
+
+    cout << "Interrupt test: " << numEvents << " devices, ";
+    cout << numInterrupts << " interrupts in " << elapsed << " seconds";
+    if (numInterrupts > 0) {
+	cout << ", " << (elapsed * 1.0e6 / numInterrupts) << " usec each";
+    }
+    cout << "\n";
+}
+
 // Chanwei add
 void
 Interrupt::SliceForward()
 {
 	int currentTime = kernel->stats->totalTicks;
-    ListIterator<PendingInterrupt *> *iterator = new ListIterator<PendingInterrupt *>(pending);
+    PendingInterrupt *timer = NULL;
     // find the first timer int and stop it.
-    for(; !(iterator->IsDone()); iterator->Next()) {
-        if(iterator->Item()->type == TimerInt) {
-            if(iterator->Item()->when > currentTime) {
-               int advance = TimerTicks - (iterator->Item()->when - currentTime);
-                iterator->Item()->when += advance;
-                //cout << "Tick " << currentTime  << ": Slice forward to " <<     iterator->Item()->when << endl;
-                break;
-            }
+    for (int i = 0; i < pending->NumInHeap(); i++) {
+        PendingInterrupt *next = pending->Item(i);
+        if (next->type == TimerInt && next->when > currentTime
+                && (timer == NULL || next->when < timer->when)) {
+            timer = next;
         }
     }
+    if (timer != NULL) {
+        // start a whole new slice; take it out and put it back in,
+        // to keep the heap in order
+        pending->Remove(timer);
+        timer->when = currentTime + TimerTicks;
+        pending->Insert(timer);
+    }
 }
@@ -35,6 +35,7 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "heap.h"
 #include "callback.h"
 
 typedef int OpenFileId;
@@ -68,6 +69,10 @@ class PendingInterrupt {
     
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+
+    void *operator new(size_t size) { return slab.Alloc(size); }
+    void operator delete(void *p, size_t size) { slab.Free(p, size); }
+    static Slab slab;		// where pending interrupts are allocated
 };
 
 // The following class defines the data structures for the simulation
@@ -106,10 +111,16 @@ class Interrupt {
 				// from an interrupt handler
 
     MachineStatus getStatus() { return status; } 
+    bool YieldingFromUser();	// Is the current thread yielding, after
+				// an interrupt between two user
+				// instructions?  (Only says so once.)
     void setStatus(MachineStatus st) { status = st; }
         			// idle, kernel, user
 
     void DumpState();		// Print interrupt state
+    void SelfTest(int numEvents);
+    				// Time scheduling and firing lots of
+				// device interrupts
     
 
     // NOTE: the following are internal to the hardware simulation code.
@@ -123,6 +134,14 @@ class Interrupt {
     				// by the hardware device simulators.
     
     void OneTick();       	// Advance simulated time
+
+    int Horizon();		// When the next pending interrupt is due;
+				// until then, OneTick has nothing to do
+				// but advance the clock
+    bool OnlyInputPending();	// Are the only pending interrupts polls
+				// for console or network input?
+    int DeviceHorizon();	// When the next interrupt is due that
+				// isn't the timer, or a poll for input
 	
 	// Chanwei add
 	void SliceForward();
@@ -130,15 +149,17 @@ class Interrupt {
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;		
-    				// the list of interrupts scheduled
-				// to occur in the future
+    Heap<PendingInterrupt *> *pending;
+    				// the interrupts scheduled to occur
+				// in the future, earliest first
     //int writeFileNo;            //UNIX file emulating the display
     bool inHandler;		// TRUE if we are running an interrupt handler
     //bool putBusy;               // Is a PrintInt operation in progress
                                   //If so, you cannoot do another one
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
+    bool userYield;		// TRUE if the thread is context switching
+				// that way, and was running user code
     MachineStatus status;	// idle, kernel mode, user mode
 
     // these functions are internal to the interrupt simulation code
@@ -50,31 +50,133 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"checkTranslation" -- if TRUE, check each instruction run by the
+//		block translator against the interpreter (only if Nachos
+//		was compiled with TRANSLATE_BLOCKS).
+//	"tlbEntries", "tlbAssoc", "tlbReplace" -- the size of the TLB,
+//		the number of entries per set, and the replacement policy
+//		(only if Nachos was compiled with USE_TLB).
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool checkTranslation, int tlbEntries, 
+		 int tlbAssoc, TLBPolicy tlbReplace)
 {
     int i;
 
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
+    stats = kernel->stats;
+    ownsMemory = TRUE;
+    runningAhead = stopped = FALSE;
     mainMemory = new char[MemorySize];
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
+    decodeCache = new Instruction[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+	decodeCache[i].decoded = FALSE;
+#ifdef TRANSLATE_BLOCKS
+    blockCache = new TranslatedBlock *[MemorySize / 4];
+    for (i = 0; i < MemorySize / 4; i++)
+	blockCache[i] = NULL;
+    blocksStale = FALSE;
+#ifdef x86_64
+    nativeCode = AllocCodeArray(NativeCodeSize);
+    nativeUsed = 0;
+#endif
+#endif
+    checkBlocks = checkTranslation;
+    ASSERT(tlbEntries > 0 && tlbAssoc > 0 && tlbEntries % tlbAssoc == 0);
+    tlbSize = tlbEntries;
+    tlbWays = tlbAssoc;
+    tlbPolicy = tlbReplace;
+    tlbClock = 0;
+    icache = dcache = NULL;
+    profileCounts = NULL;
+    currentASID = 0;
 #ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
+    tlb = new TranslationEntry[tlbSize];
+    tlbStamp = new int[tlbSize];
+    for (i = 0; i < tlbSize; i++) {
 	tlb[i].valid = FALSE;
+	tlbStamp[i] = 0;
+    }
     pageTable = NULL;
 #else	// use linear page table
     tlb = NULL;
+    tlbStamp = NULL;
     pageTable = NULL;
 #endif
 
     singleStep = debug;
+    // a hit in the soft TLB would bypass the simulated TLB's counters
+    // and replacement policy
+    useSoftTLB = !::debug->IsEnabled(dbgAddr) && (tlb == NULL);
+#ifdef TRANSLATE_BLOCKS
+    useBlocks = useSoftTLB && !::debug->IsEnabled(dbgMach);
+#endif
+    FlushSoftTLB();
+    horizon = 0;
+    batchedTicks = 0;
+    batchedInstructions = 0;
+    SetInstructionCosts(UserTick, UserTick, UserTick, 0);
     CheckEndian();
 }
 
+//----------------------------------------------------------------------
+// Machine::Machine
+// 	Initialize the simulation of another CPU of a multiprocessor,
+//	to run user instructions on a host thread of its own (see
+//	HostCPU).  It shares main memory, and the instructions predecoded
+//	there, with the first CPU, and has the same cost model; but it
+//	has registers, a soft TLB and a clock of its own.  There is no
+//	TLB, cache or profile: the kernel refuses -parallel with those.
+//
+//	"firstCPU" -- the machine the kernel runs on
+//	"cpuStats" -- where to keep this CPU's clock, and count the user
+//		ticks and instructions it runs
+//----------------------------------------------------------------------
+
+Machine::Machine(Machine *firstCPU, Statistics *cpuStats)
+{
+    for (int i = 0; i < NumTotalRegs; i++)
+        registers[i] = 0;
+    stats = cpuStats;
+    ownsMemory = FALSE;
+    runningAhead = stopped = FALSE;
+    mainMemory = firstCPU->mainMemory;
+    decodeCache = firstCPU->decodeCache;
+#ifdef TRANSLATE_BLOCKS
+    blockCache = NULL;
+    blocksStale = FALSE;
+    useBlocks = FALSE;
+#ifdef x86_64
+    nativeCode = NULL;
+    nativeUsed = 0;
+#endif
+#endif
+    checkBlocks = FALSE;
+    tlb = NULL;
+    tlbStamp = NULL;
+    tlbSize = tlbWays = firstCPU->tlbSize;
+    tlbPolicy = firstCPU->tlbPolicy;
+    tlbClock = 0;
+    icache = dcache = NULL;
+    profileCounts = NULL;
+    currentASID = 0;
+    pageTable = NULL;
+    pageTableSize = 0;
+    singleStep = FALSE;
+    useSoftTLB = firstCPU->useSoftTLB;
+    FlushSoftTLB();
+    horizon = 0;
+    batchedTicks = 0;
+    batchedInstructions = 0;
+    for (int i = 0; i < NumOpcodes; i++)
+	opExtraTicks[i] = firstCPU->opExtraTicks[i];
+    takenBranchTicks = firstCPU->takenBranchTicks;
+    extraTicks = 0;
+}
+
 //----------------------------------------------------------------------
 // Machine::~Machine
 // 	De-allocate the data structures used to simulate user program execution.
@@ -82,9 +184,41 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
-    delete [] mainMemory;
-    if (tlb != NULL)
+    if (ownsMemory) {
+	delete [] mainMemory;
+	delete [] decodeCache;
+#ifdef TRANSLATE_BLOCKS
+	FlushBlocks();
+	delete [] blockCache;
+#ifdef x86_64
+	if (nativeCode != NULL)
+	    DeallocCodeArray(nativeCode, NativeCodeSize);
+#endif
+#endif
+    }
+    delete icache;
+    delete dcache;
+    delete [] profileCounts;
+    if (tlb != NULL) {
         delete [] tlb;
+	delete [] tlbStamp;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::StartProfiling
+// 	Count how many times each user instruction is executed, by 
+//	physical address (see profileCounts).  It's up to the kernel
+//	to make sense of the counts -- see AddrSpace::PrintProfile.
+//----------------------------------------------------------------------
+
+void
+Machine::StartProfiling()
+{
+    if (profileCounts == NULL) {
+	profileCounts = new int[MemorySize / 4];
+	bzero(profileCounts, (MemorySize / 4) * sizeof(int));
+    }
 }
 
 //----------------------------------------------------------------------
@@ -93,6 +227,11 @@ Machine::~Machine()
 //	the user program either invoked a system call, or some exception
 //	occured (such as the address translation failed).
 //
+//	In RunAhead, there is no kernel to transfer to: just stop.  The
+//	instruction hasn't changed anything yet (as after a page fault,
+//	it is simply run again), so the kernel's machine runs it again,
+//	and traps, when the thread gets back to it.
+//
 //	"which" -- the cause of the kernel trap
 //	"badVaddr" -- the virtual address causing the trap, if appropriate
 //----------------------------------------------------------------------
@@ -100,12 +239,19 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    if (runningAhead) {		// leave it for the kernel's machine
+	stopped = TRUE;
+	return;
+    }
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
+    FlushTicks();			// the kernel may look at the clock
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
     kernel->interrupt->setStatus(SystemMode);
     ExceptionHandler(which);		// interrupts are enabled at this point
     kernel->interrupt->setStatus(UserMode);
+    UpdateHorizon();			// the kernel may have scheduled
+					// an interrupt
 }
 
 //----------------------------------------------------------------------
@@ -129,7 +275,7 @@ void Machine::Debugger()
     while (!done) {
       // read commands until we should proceed with more execution
       // prompt for input, giving current simulation time in the prompt
-      cout << kernel->stats->totalTicks << ">";
+      cout << stats->totalTicks << ">";
       // read one line of input (80 chars max)
       cin.get(buf, 80);
       if (sscanf(buf, "%d", &num) == 1) {
@@ -24,6 +24,8 @@
 #include "copyright.h"
 #include "utility.h"
 #include "translate.h"
+#include "mipsblock.h"
+#include "cache.h"
 
 // Definitions related to the size, and format of user memory
 
@@ -39,6 +41,13 @@ const int NumPhysPages = 128;
 
 const int MemorySize = (NumPhysPages * PageSize);
 const int TLBSize = 4;			// if there is a TLB, make it small
+					// (default; see "nachos -tlb")
+const int NumASIDs = 64;		// address space identifiers (TLB tags)
+const int NumOpcodes = 64;		// opcodes in the decoded form of an
+					// instruction (MaxOpcode + 1, in
+					// mipssim.h)
+const int SoftTLBSize = 32;		// entries in the simulator's private
+					// translation cache (see translate.h)
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -56,6 +65,14 @@ enum ExceptionType { NoException,           // Everything ok!
 		     NumExceptionTypes
 };
 
+// How the TLB chooses which entry of a set to replace, when the kernel
+// refills it (see Machine::RefillTLB) and the set is full.
+
+enum TLBPolicy { TLBRandom,		// any entry in the set
+		 TLBFIFO,		// the entry loaded longest ago
+		 TLBLRU			// the entry used longest ago
+};
+
 // User program CPU state.  The full set of MIPS registers, plus a few
 // more because we need to be able to start/stop a user program between
 // any two instructions (thus we need to keep track of things like load
@@ -88,23 +105,65 @@ enum ExceptionType { NoException,           // Everything ok!
 // The procedures in this class are defined in machine.cc, mipssim.cc, and
 // translate.cc.
 
-class Instruction;
+// The following class defines an instruction, represented in both
+// 	undecoded binary form
+//      decoded to identify
+//	    operation to do
+//	    registers to act on
+//	    any immediate operand value
+//
+// The machine keeps one of these for every word of physical memory
+// (see "decodeCache" below), so that an instruction only needs to be
+// decoded the first time it is fetched, not every time it is executed.
+
+class Instruction {
+  public:
+    void Decode();	// decode the binary representation of the instruction
+
+    unsigned int value; // binary representation of the instruction
+
+    char opCode;     // Type of instruction.  This is NOT the same as the
+    		     // opcode field from the instruction: see defs in mips.h
+    char rs, rt, rd; // Three registers from instruction.
+    int extra;       // Immediate or target or shamt field or offset.
+                     // Immediates are sign-extended.
+    bool decoded;    // FALSE if the word in memory has not been decoded
+		     // since it was last written
+};
+
 class Interrupt;
+class Statistics;
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
+    Machine(bool debug, bool checkTranslation, int tlbEntries, int tlbAssoc,
+	    TLBPolicy tlbReplace);
+				// Initialize the simulation of the hardware
 				// for running user programs
+    Machine(Machine *firstCPU, Statistics *cpuStats);
+				// Initialize another CPU, which shares
+				// the first one's memory, but keeps its
+				// time in "cpuStats" (see HostCPU)
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
     void Run();	 		// Run a user program
 
+    void RunAhead(int until);	// Run user instructions, without ever
+				// entering the kernel, until the clock
+				// reaches "until" (see HostCPU)
+
     int ReadRegister(int num);	// read the contents of a CPU register
 
     void WriteRegister(int num, int value);
 				// store a value into a CPU register
 
+    void SetInstructionCosts(int multiply, int divide, int memory,
+			     int takenBranch);
+				// set how many ticks multiplies, divides
+				// and loads/stores take, and the extra
+				// ticks for a taken branch or jump
+
 // Data structures accessible to the Nachos kernel -- main memory and the
 // page table/TLB.
 //
@@ -134,6 +193,27 @@ class Machine {
 
     TranslationEntry *tlb;		// this pointer should be considered 
 					// "read-only" to Nachos kernel code
+    int tlbSize;			// number of entries in the TLB
+    int tlbWays;			// entries per set: the TLB entry for
+					// virtual page "vpn" can only be in
+					// set vpn % (tlbSize / tlbWays), i.e.,
+					// tlb[set * tlbWays .. + tlbWays - 1]
+
+    int currentASID;			// the address space that is running;
+					// TLB entries of others are ignored
+
+    Cache *icache;			// level 1 instruction and data caches,
+    Cache *dcache;			// or NULL if they aren't simulated
+
+    int *profileCounts;			// if profiling, the number of times
+					// the instruction in each word of
+					// mainMemory was executed; else NULL
+    void StartProfiling();		// start counting them
+
+    void RefillTLB(TranslationEntry *entry);
+				// Load a copy of a translation into the 
+				// TLB, replacing an entry of its set if
+				// necessary (like MIPS "tlbwr")
 
     TranslationEntry *pageTable;
     unsigned int pageTableSize;
@@ -143,14 +223,56 @@ class Machine {
     				// Read or write 1, 2, or 4 bytes of virtual 
 				// memory (at addr).  Return FALSE if a 
 				// correct translation couldn't be found.
+
+    void InvalidateCode(int physAddr, int size);
+				// The kernel wrote "size" bytes of mainMemory
+				// directly (e.g., loading a program);
+				// forget any predecoded instructions there
+
+    void FlushSoftTLB();	// The kernel switched page tables, or changed
+				// an entry of the page table or TLB; forget
+				// the simulator's cached translations
   private:
 
 // Routines internal to the machine simulation -- DO NOT call these directly
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
 
-    void OneInstruction(Instruction *instr); 	
-    				// Run one instruction of a user program.
+    void OneInstruction(); 	// Run one instruction of a user program.
+
+    void AdvanceClock();	// Account for one executed user instruction,
+				// calling OneTick only when it has 
+				// something to do
+    void FlushTicks();		// Add any batched ticks to the statistics
+    void UpdateHorizon();	// Recompute when we next need OneTick
+
+    Instruction *FetchInstruction();
+				// Return the predecoded instruction at
+				// the PC, decoding it if necessary
+    Instruction *DecodeWord(int physAddr);
+				// Same, for a physical address
+
+#ifdef TRANSLATE_BLOCKS
+    bool RunBlock();		// Run translated instructions from the PC,
+				// if possible
+    TranslatedBlock *TranslateBlock(int virtAddr, int physAddr);
+				// Translate the block starting at virtAddr
+    bool RunBlockOp(BlockOp *op);
+				// Execute one translated instruction
+    void CheckBlockOp(BlockOp *op, int *before);
+				// Compare a translated instruction's results
+				// with the interpreter's
+    void FlushBlocks();		// Throw away all translated blocks
+#ifdef x86_64
+    NativeBlock CompileBlock(TranslatedBlock *block);
+				// Generate host code for a hot block
+    int RunNativeBlock(TranslatedBlock *block, int physAddr, int budget,
+		       int *ticks);
+				// Run a block's host code, if it can't
+				// reach the horizon; return how many
+				// instructions it ran
+#endif
+#endif
     
 
 
@@ -161,6 +283,11 @@ class Machine {
     				// and return an exception code if the 
 				// translation couldn't be completed.
 
+    char *SoftTranslate(int virtAddr, int size, bool writing);
+				// Look for the address in the soft TLB;
+				// return where it is in mainMemory, or
+				// NULL if Translate must be called
+
     void RaiseException(ExceptionType which, int badVAddr);
 				// Trap to the Nachos kernel, because of a
 				// system call or other exception.  
@@ -173,6 +300,57 @@ class Machine {
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    Statistics *stats;		// where the clock is, and the counters
+				// user instructions update
+    bool ownsMemory;		// FALSE if mainMemory (and decodeCache)
+				// belong to another CPU
+    bool runningAhead;		// TRUE inside RunAhead: stop, rather than
+				// call the kernel
+    bool stopped;		// set when RunAhead must stop
+
+    SoftTLBEntry softTLB[SoftTLBSize];
+				// direct-mapped cache of recent
+				// translations, indexed by virtual page #
+    bool useSoftTLB;		// FALSE when tracing addresses ('-d a'),
+				// or simulating a TLB, so that every
+				// access goes via Translate
+
+    TLBPolicy tlbPolicy;	// which TLB entry RefillTLB replaces
+    int *tlbStamp;		// for each TLB entry, when it was loaded
+				// (FIFO) or last used (LRU)
+    int tlbClock;		// counts TLB loads and uses, for tlbStamp
+
+    Instruction *decodeCache;	// predecoded instructions, one per word
+				// of mainMemory (so, per physical page,
+				// PageSize/4 of them).  Entries are
+				// invalidated when the word is written.
+
+#ifdef TRANSLATE_BLOCKS
+    TranslatedBlock **blockCache; // translated blocks, by the physical
+				// word where they start
+    bool blocksStale;		// TRUE if code that was translated has
+				// since been overwritten
+    bool useBlocks;		// FALSE when tracing instructions or
+				// addresses, which blocks would skip
+#ifdef x86_64
+    char *nativeCode;		// where CompileBlock puts host code, or
+				// NULL if the host won't run it
+    int nativeUsed;		// bytes of nativeCode used so far
+#endif
+#endif
+    bool checkBlocks;		// run every translated instruction through
+				// the interpreter too, and compare
+
+    int horizon;		// execute user instructions without calling
+				// OneTick until totalTicks reaches this
+    int batchedTicks;		// user ticks executed since the last call
+				// to OneTick, not yet in the statistics
+    int batchedInstructions;	// and the number of instructions
+
+    int opExtraTicks[NumOpcodes]; // ticks each opcode takes beyond UserTick
+    int takenBranchTicks;	// extra ticks when a branch is taken
+    int extraTicks;		// extra ticks for the instruction just run
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
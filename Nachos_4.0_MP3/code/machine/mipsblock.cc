@@ -0,0 +1,621 @@
+// mipsblock.cc -- translate straight-line MIPS code into blocks of
+//	specialized operations, and run them (see mipsblock.h).
+//
+//   The translated operations do exactly what the interpreter in
+//   mipssim.cc does for the same instructions, including its delayed
+//   loads, so that the two engines can be freely mixed: the machine
+//   runs a translated block when it can, and falls back to
+//   OneInstruction for everything else.  Running Nachos with "-tc"
+//   checks every translated instruction against OneInstruction.
+//
+//   Only compiled in if TRANSLATE_BLOCKS is defined.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#ifdef TRANSLATE_BLOCKS
+
+#define MIPSSIM_OPCODES_ONLY
+#include "debug.h"
+#include "machine.h"
+#include "mipssim.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// TranslateInstruction
+// 	Fill in "op" with the translation of a decoded instruction,
+//	found at virtual address "pc".  Return FALSE if the instruction
+//	is left to the interpreter.
+//----------------------------------------------------------------------
+
+static bool
+TranslateInstruction(Instruction *instr, int pc, BlockOp *op)
+{
+    int dest = -1;		// register written, for simple ops
+
+    op->pc = pc;
+    op->opCode = instr->opCode;
+    op->rs = instr->rs;
+    op->rt = instr->rt;
+    op->rd = instr->rd;
+    op->imm = instr->extra;
+
+    switch (instr->opCode) {
+      case OP_ADD:	op->type = BLK_ADD; break;
+      case OP_ADDI:	op->type = BLK_ADDI; break;
+      case OP_SUB:	op->type = BLK_SUB; break;
+      case OP_ADDU:
+	op->type = (op->rt == 0) ? BLK_MOVE : BLK_ADDU;
+	dest = op->rd;
+	break;
+      case OP_SUBU:	op->type = BLK_SUBU; dest = op->rd; break;
+      case OP_AND:	op->type = BLK_AND; dest = op->rd; break;
+      case OP_XOR:	op->type = BLK_XOR; dest = op->rd; break;
+      case OP_NOR:	op->type = BLK_NOR; dest = op->rd; break;
+      case OP_SLT:	op->type = BLK_SLT; dest = op->rd; break;
+      case OP_SLTU:	op->type = BLK_SLTU; dest = op->rd; break;
+      case OP_SLTI:	op->type = BLK_SLTI; dest = op->rt; break;
+      case OP_SLTIU:	op->type = BLK_SLTIU; dest = op->rt; break;
+      case OP_SLL:	op->type = BLK_SLL; dest = op->rd; break;
+      case OP_SRL:	op->type = BLK_SRL; dest = op->rd; break;
+      case OP_SRA:	op->type = BLK_SRA; dest = op->rd; break;
+      case OP_SLLV:	op->type = BLK_SLLV; dest = op->rd; break;
+      case OP_SRLV:	op->type = BLK_SRLV; dest = op->rd; break;
+      case OP_SRAV:	op->type = BLK_SRAV; dest = op->rd; break;
+      case OP_MFHI:	op->type = BLK_MFHI; dest = op->rd; break;
+      case OP_MFLO:	op->type = BLK_MFLO; dest = op->rd; break;
+      case OP_MTHI:	op->type = BLK_MTHI; break;
+      case OP_MTLO:	op->type = BLK_MTLO; break;
+      case OP_MULT:	op->type = BLK_MULT; break;
+      case OP_MULTU:	op->type = BLK_MULTU; break;
+      case OP_DIV:	op->type = BLK_DIV; break;
+      case OP_DIVU:	op->type = BLK_DIVU; break;
+      case OP_LB:	op->type = BLK_LB; break;
+      case OP_LBU:	op->type = BLK_LBU; break;
+      case OP_LH:	op->type = BLK_LH; break;
+      case OP_LHU:	op->type = BLK_LHU; break;
+      case OP_LW:	op->type = BLK_LW; break;
+      case OP_SB:	op->type = BLK_SB; break;
+      case OP_SH:	op->type = BLK_SH; break;
+      case OP_SW:	op->type = BLK_SW; break;
+      case OP_JR:	op->type = BLK_JR; break;
+      case OP_JALR:	op->type = BLK_JALR; break;
+
+      case OP_OR:
+	op->type = (op->rt == 0) ? BLK_MOVE : BLK_OR;
+	dest = op->rd;
+	break;
+      case OP_ADDIU:
+	op->type = (op->rs == 0) ? BLK_LI : BLK_ADDIU;
+	dest = op->rt;
+	break;
+      case OP_ANDI:
+	op->type = BLK_ANDI;
+	op->imm &= 0xffff;
+	dest = op->rt;
+	break;
+      case OP_ORI:
+	op->imm &= 0xffff;
+	op->type = (op->rs == 0) ? BLK_LI : BLK_ORI;
+	dest = op->rt;
+	break;
+      case OP_XORI:
+	op->type = BLK_XORI;
+	op->imm &= 0xffff;
+	dest = op->rt;
+	break;
+      case OP_LUI:
+	op->type = BLK_LI;
+	op->imm = instr->extra << 16;
+	dest = op->rt;
+	break;
+
+      case OP_BEQ:	op->type = BLK_BEQ; break;
+      case OP_BNE:	op->type = BLK_BNE; break;
+      case OP_BLEZ:	op->type = BLK_BLEZ; break;
+      case OP_BGTZ:	op->type = BLK_BGTZ; break;
+      case OP_BLTZ:	op->type = BLK_BLTZ; break;
+      case OP_BGEZ:	op->type = BLK_BGEZ; break;
+      case OP_BLTZAL:	op->type = BLK_BLTZAL; break;
+      case OP_BGEZAL:	op->type = BLK_BGEZAL; break;
+      case OP_J:	op->type = BLK_J; break;
+      case OP_JAL:	op->type = BLK_JAL; break;
+
+      default:		// system calls, LWL/LWR/SWL/SWR, reserved, ...
+	return FALSE;
+    }
+
+    // Branch targets are relative to the delay slot, which the machine
+    // only translates at pc + 4 (see Machine::RunBlock).
+    switch (op->type) {
+      case BLK_BEQ: case BLK_BNE: case BLK_BLEZ: case BLK_BGTZ:
+      case BLK_BLTZ: case BLK_BGEZ: case BLK_BLTZAL: case BLK_BGEZAL:
+	op->imm = pc + 4 + IndexToAddr(instr->extra);
+	break;
+      case BLK_J: case BLK_JAL:
+	op->imm = ((pc + 8) & 0xf0000000) | IndexToAddr(instr->extra);
+	break;
+      default:
+	break;
+    }
+
+    // An operation whose only effect is to write register 0 does
+    // nothing, since register 0 is always reset after each instruction.
+    if (dest == 0) {
+	op->type = BLK_NOP;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::TranslateBlock
+// 	Translate the instructions starting at virtual address "virtAddr"
+//	(physical address "physAddr"), up to and including the delay slot
+//	of the first branch or jump.  Stop early at the first instruction
+//	that can't be translated, at the end of the physical page (the
+//	next page may not be the next frame), or after MaxBlockLength
+//	instructions.
+//----------------------------------------------------------------------
+
+TranslatedBlock *
+Machine::TranslateBlock(int virtAddr, int physAddr)
+{
+    TranslatedBlock *block = new TranslatedBlock;
+    int pageEnd = (physAddr / PageSize + 1) * PageSize;
+    bool inDelaySlot = FALSE;
+
+    block->pc = virtAddr;
+    block->length = 0;
+    block->runs = 0;
+    block->native = NULL;
+    while (physAddr < pageEnd && block->length < MaxBlockLength) {
+	BlockOp *op = &block->ops[block->length];
+
+	if (!TranslateInstruction(DecodeWord(physAddr), virtAddr, op)) {
+	    break;
+	}
+	if (inDelaySlot && op->IsBranch()) {	// leave these oddities to
+	    break;				// the interpreter
+	}
+	block->length++;
+	if (inDelaySlot) {
+	    break;
+	}
+	inDelaySlot = op->IsBranch();
+	physAddr += 4;
+	virtAddr += 4;
+    }
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Run translated instructions, starting at the current PC, for
+//	as long as possible without reaching the next pending interrupt.
+//	Returns FALSE if no instruction could be run this way, in which
+//	case the caller should use OneInstruction.
+//
+//	Blocks are only entered when NextPC is PC + 4, i.e., not in the
+//	delay slot of a branch executed elsewhere.  Like AdvanceClock,
+//	we leave the clock to batchedTicks, charging each instruction
+//	according to the cost model.
+//
+//	On an x86-64 host, once a block is hot, its host code runs as
+//	much of it as it can, and the operations only do the rest.
+//----------------------------------------------------------------------
+
+bool
+Machine::RunBlock()
+{
+    int pc = registers[PCReg];
+    int budget, physAddr, done, elapsed, ticks, nextPC;
+    char *hostAddress;
+    TranslatedBlock *block;
+    int before[NumTotalRegs];
+
+    if (blocksStale) {		// translated code was overwritten
+	FlushBlocks();
+    }
+    budget = horizon - (stats->totalTicks + batchedTicks) - 1;
+    if (!useBlocks || budget <= 0 || registers[NextPCReg] != pc + 4
+	    || icache != NULL || dcache != NULL) {	// blocks skip the caches
+	return FALSE;
+    }
+
+    hostAddress = SoftTranslate(pc, 4, FALSE);
+    if (hostAddress != NULL) {
+	physAddr = hostAddress - mainMemory;
+    } else if (Translate(pc, &physAddr, 4, FALSE) != NoException) {
+	return FALSE;		// let the interpreter raise the exception
+    }
+
+    block = blockCache[physAddr >> 2];
+    if (block == NULL || block->pc != pc) {
+	delete block;
+	block = TranslateBlock(pc, physAddr);
+	blockCache[physAddr >> 2] = block;
+    }
+
+    done = elapsed = 0;
+#ifdef x86_64
+    if (block->native == NULL && ++block->runs == HotBlockRuns
+	    && nativeCode != NULL) {
+	block->native = CompileBlock(block);
+    }
+    if (block->native != NULL) {
+	done = RunNativeBlock(block, physAddr, budget, &elapsed);
+    }
+#endif
+    while (done < block->length) {
+	BlockOp *op = &block->ops[done];
+
+	if (op->pc != registers[PCReg]) {	// branched out of the block
+	    break;
+	}
+	ticks = UserTick + opExtraTicks[(int) op->opCode];
+	if (elapsed + ticks + (op->IsBranch() ? takenBranchTicks : 0) > budget) {
+	    break;			// might reach the horizon
+	}
+	if (checkBlocks) {
+	    bcopy(registers, before, sizeof(registers));
+	}
+	nextPC = registers[NextPCReg];
+	if (!RunBlockOp(op)) {		// the interpreter must do this one
+	    break;
+	}
+	done++;
+	if (profileCounts != NULL && !checkBlocks) {	// else counted by
+	    profileCounts[(physAddr + op->pc - pc) >> 2]++;	// CheckBlockOp
+	}
+	if (registers[NextPCReg] != nextPC + 4) {	// branch taken
+	    ticks += takenBranchTicks;
+	}
+	elapsed += ticks;
+	if (checkBlocks) {
+	    CheckBlockOp(op, before);
+	}
+	if (blocksStale) {		// we may have overwritten this block
+	    break;
+	}
+    }
+    batchedTicks += elapsed;
+    batchedInstructions += done;
+    return (done > 0);
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlockOp
+// 	Execute one translated instruction, the same way OneInstruction
+//	would.  If the instruction would cause an exception (overflow,
+//	or an address that is not in the soft TLB), return FALSE before
+//	changing anything, so the interpreter can execute it instead.
+//----------------------------------------------------------------------
+
+bool
+Machine::RunBlockOp(BlockOp *op)
+{
+    int pcAfter = registers[NextPCReg] + 4;
+    int nextLoadReg = 0;
+    int nextLoadValue = 0;
+    int sum, addr;
+    unsigned int rs, rt;
+    long long product;
+    char *hostAddress;
+
+    switch (op->type) {
+      case BLK_NOP:
+	break;
+      case BLK_LI:
+	registers[op->rt] = op->imm;
+	break;
+      case BLK_MOVE:
+	registers[op->rd] = registers[op->rs];
+	break;
+
+      case BLK_ADD:
+	sum = registers[op->rs] + registers[op->rt];
+	if (!((registers[op->rs] ^ registers[op->rt]) & SIGN_BIT) &&
+	    ((registers[op->rs] ^ sum) & SIGN_BIT)) {
+	    return FALSE;		// overflow
+	}
+	registers[op->rd] = sum;
+	break;
+      case BLK_ADDI:
+	sum = registers[op->rs] + op->imm;
+	if (!((registers[op->rs] ^ op->imm) & SIGN_BIT) &&
+	    ((op->imm ^ sum) & SIGN_BIT)) {
+	    return FALSE;		// overflow
+	}
+	registers[op->rt] = sum;
+	break;
+      case BLK_SUB:
+	sum = registers[op->rs] - registers[op->rt];
+	if (((registers[op->rs] ^ registers[op->rt]) & SIGN_BIT) &&
+	    ((registers[op->rs] ^ sum) & SIGN_BIT)) {
+	    return FALSE;		// overflow
+	}
+	registers[op->rd] = sum;
+	break;
+
+      case BLK_ADDU:
+	registers[op->rd] = registers[op->rs] + registers[op->rt];
+	break;
+      case BLK_ADDIU:
+	registers[op->rt] = registers[op->rs] + op->imm;
+	break;
+      case BLK_SUBU:
+	registers[op->rd] = registers[op->rs] - registers[op->rt];
+	break;
+      case BLK_AND:
+	registers[op->rd] = registers[op->rs] & registers[op->rt];
+	break;
+      case BLK_ANDI:
+	registers[op->rt] = registers[op->rs] & op->imm;
+	break;
+      case BLK_OR:
+	registers[op->rd] = registers[op->rs] | registers[op->rt];
+	break;
+      case BLK_ORI:
+	registers[op->rt] = registers[op->rs] | op->imm;
+	break;
+      case BLK_XOR:
+	registers[op->rd] = registers[op->rs] ^ registers[op->rt];
+	break;
+      case BLK_XORI:
+	registers[op->rt] = registers[op->rs] ^ op->imm;
+	break;
+      case BLK_NOR:
+	registers[op->rd] = ~(registers[op->rs] | registers[op->rt]);
+	break;
+      case BLK_SLT:
+	registers[op->rd] = (registers[op->rs] < registers[op->rt]);
+	break;
+      case BLK_SLTI:
+	registers[op->rt] = (registers[op->rs] < op->imm);
+	break;
+      case BLK_SLTU:
+	rs = registers[op->rs];
+	rt = registers[op->rt];
+	registers[op->rd] = (rs < rt);
+	break;
+      case BLK_SLTIU:
+	rs = registers[op->rs];
+	registers[op->rt] = (rs < (unsigned int) op->imm);
+	break;
+
+      case BLK_SLL:
+	registers[op->rd] = registers[op->rt] << op->imm;
+	break;
+      case BLK_SRL:		// OneInstruction shifts a signed int here
+      case BLK_SRA:
+	registers[op->rd] = registers[op->rt] >> op->imm;
+	break;
+      case BLK_SLLV:
+	registers[op->rd] = registers[op->rt] << (registers[op->rs] & 0x1f);
+	break;
+      case BLK_SRLV:		// likewise
+      case BLK_SRAV:
+	registers[op->rd] = registers[op->rt] >> (registers[op->rs] & 0x1f);
+	break;
+
+      case BLK_MFHI:
+	registers[op->rd] = registers[HiReg];
+	break;
+      case BLK_MFLO:
+	registers[op->rd] = registers[LoReg];
+	break;
+      case BLK_MTHI:
+	registers[HiReg] = registers[op->rs];
+	break;
+      case BLK_MTLO:
+	registers[LoReg] = registers[op->rs];
+	break;
+      case BLK_MULT:
+	product = (long long) registers[op->rs] * registers[op->rt];
+	registers[HiReg] = (int) (product >> 32);
+	registers[LoReg] = (int) product;
+	break;
+      case BLK_MULTU:
+	product = (long long) ((unsigned long long)
+				(unsigned int) registers[op->rs] *
+				(unsigned int) registers[op->rt]);
+	registers[HiReg] = (int) (product >> 32);
+	registers[LoReg] = (int) product;
+	break;
+      case BLK_DIV:
+	if (registers[op->rt] == 0) {
+	    registers[LoReg] = 0;
+	    registers[HiReg] = 0;
+	} else {
+	    registers[LoReg] = registers[op->rs] / registers[op->rt];
+	    registers[HiReg] = registers[op->rs] % registers[op->rt];
+	}
+	break;
+      case BLK_DIVU:
+	rs = registers[op->rs];
+	rt = registers[op->rt];
+	if (rt == 0) {
+	    registers[LoReg] = 0;
+	    registers[HiReg] = 0;
+	} else {
+	    registers[LoReg] = (int) (rs / rt);
+	    registers[HiReg] = (int) (rs % rt);
+	}
+	break;
+
+      case BLK_LB:
+      case BLK_LBU:
+	addr = registers[op->rs] + op->imm;
+	if ((hostAddress = SoftTranslate(addr, 1, FALSE)) == NULL) {
+	    return FALSE;
+	}
+	if (op->type == BLK_LB) {
+	    nextLoadValue = (signed char) *hostAddress;
+	} else {
+	    nextLoadValue = (unsigned char) *hostAddress;
+	}
+	nextLoadReg = op->rt;
+	break;
+      case BLK_LH:
+      case BLK_LHU:
+	addr = registers[op->rs] + op->imm;
+	if ((hostAddress = SoftTranslate(addr, 2, FALSE)) == NULL) {
+	    return FALSE;
+	}
+	nextLoadValue = ShortToHost(*(unsigned short *) hostAddress);
+	if (op->type == BLK_LH) {
+	    nextLoadValue = (short) nextLoadValue;
+	}
+	nextLoadReg = op->rt;
+	break;
+      case BLK_LW:
+	addr = registers[op->rs] + op->imm;
+	if ((hostAddress = SoftTranslate(addr, 4, FALSE)) == NULL) {
+	    return FALSE;
+	}
+	nextLoadValue = WordToHost(*(unsigned int *) hostAddress);
+	nextLoadReg = op->rt;
+	break;
+
+      case BLK_SB:
+	addr = registers[op->rs] + op->imm;
+	if ((hostAddress = SoftTranslate(addr, 1, TRUE)) == NULL) {
+	    return FALSE;
+	}
+	*hostAddress = (unsigned char) (registers[op->rt] & 0xff);
+	if (decodeCache[(hostAddress - mainMemory) >> 2].decoded) {
+	    InvalidateCode(hostAddress - mainMemory, 1);
+	}
+	break;
+      case BLK_SH:
+	addr = registers[op->rs] + op->imm;
+	if ((hostAddress = SoftTranslate(addr, 2, TRUE)) == NULL) {
+	    return FALSE;
+	}
+	*(unsigned short *) hostAddress
+		= ShortToMachine((unsigned short) (registers[op->rt] & 0xffff));
+	if (decodeCache[(hostAddress - mainMemory) >> 2].decoded) {
+	    InvalidateCode(hostAddress - mainMemory, 2);
+	}
+	break;
+      case BLK_SW:
+	addr = registers[op->rs] + op->imm;
+	if ((hostAddress = SoftTranslate(addr, 4, TRUE)) == NULL) {
+	    return FALSE;
+	}
+	*(unsigned int *) hostAddress
+		= WordToMachine((unsigned int) registers[op->rt]);
+	if (decodeCache[(hostAddress - mainMemory) >> 2].decoded) {
+	    InvalidateCode(hostAddress - mainMemory, 4);
+	}
+	break;
+
+      case BLK_BEQ:
+	if (registers[op->rs] == registers[op->rt])
+	    pcAfter = op->imm;
+	break;
+      case BLK_BNE:
+	if (registers[op->rs] != registers[op->rt])
+	    pcAfter = op->imm;
+	break;
+      case BLK_BLEZ:
+	if (registers[op->rs] <= 0)
+	    pcAfter = op->imm;
+	break;
+      case BLK_BGTZ:
+	if (registers[op->rs] > 0)
+	    pcAfter = op->imm;
+	break;
+      case BLK_BLTZAL:
+	registers[R31] = op->pc + 8;
+      case BLK_BLTZ:
+	if (registers[op->rs] & SIGN_BIT)
+	    pcAfter = op->imm;
+	break;
+      case BLK_BGEZAL:
+	registers[R31] = op->pc + 8;
+      case BLK_BGEZ:
+	if (!(registers[op->rs] & SIGN_BIT))
+	    pcAfter = op->imm;
+	break;
+      case BLK_JAL:
+	registers[R31] = op->pc + 8;
+      case BLK_J:
+	pcAfter = op->imm;
+	break;
+      case BLK_JALR:
+	registers[op->rd] = op->pc + 8;
+      case BLK_JR:
+	pcAfter = registers[op->rs];
+	break;
+
+      default:
+	ASSERT(FALSE);
+    }
+
+    // Finish the instruction, as at the end of OneInstruction.
+    DelayedLoad(nextLoadReg, nextLoadValue);
+    registers[PrevPCReg] = registers[PCReg];
+    registers[PCReg] = registers[NextPCReg];
+    registers[NextPCReg] = pcAfter;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::CheckBlockOp
+// 	Self-check mode ("nachos -tc"): having just run a translated
+//	instruction, run it again with the interpreter, starting from
+//	the same registers ("before"), and make sure both agree.
+//
+//	Re-executing a load, or a store of the same value to the same
+//	place, has no further effect on memory, so only the registers
+//	need to be compared.
+//----------------------------------------------------------------------
+
+void
+Machine::CheckBlockOp(BlockOp *op, int *before)
+{
+    int after[NumTotalRegs];
+    int savedTicks = extraTicks;	// we already charged for it
+    bool agree = TRUE;
+
+    bcopy(registers, after, sizeof(registers));
+    bcopy(before, registers, sizeof(registers));
+    OneInstruction();
+    extraTicks = savedTicks;
+    for (int i = 0; i < NumTotalRegs; i++) {
+	if (registers[i] != after[i]) {
+	    cerr << "Translated instruction at PC " << op->pc;
+	    cerr << " (type " << (int) op->type << ") left register " << i;
+	    cerr << " = " << after[i] << ", interpreter: " << registers[i];
+	    cerr << "\n";
+	    agree = FALSE;
+	}
+    }
+    ASSERT(agree);
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushBlocks
+// 	Throw away all translated blocks, because some code they were
+//	translated from has been overwritten.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushBlocks()
+{
+    DEBUG(dbgMach, "Flushing translated blocks");
+    for (int i = 0; i < MemorySize / 4; i++) {
+	delete blockCache[i];
+	blockCache[i] = NULL;
+    }
+#ifdef x86_64
+    nativeUsed = 0;		// their host code too
+#endif
+    blocksStale = FALSE;
+}
+
+#endif // TRANSLATE_BLOCKS
@@ -0,0 +1,109 @@
+// mipsblock.h
+//	Data structures for the block translator, an optional second
+//	execution engine for user programs (compiled in when
+//	TRANSLATE_BLOCKS is defined -- see the Makefile).
+//
+//	Instead of fetching and decoding instructions one at a time,
+//	the translator turns a straight-line run of MIPS instructions
+//	(a "basic block", ending with a branch and its delay slot) into
+//	a list of simpler, specialized operations: register numbers and
+//	immediates are extracted, branch targets computed, and common
+//	idioms (no-ops, "load immediate", "move") recognized, ahead of
+//	time.  The block can then be executed without going back to
+//	the instruction fetch, decode, or clock for every instruction.
+//
+//	Anything the translator does not handle (system calls,
+//	unaligned loads and stores, reserved instructions) ends the
+//	block, and is left to the interpreter (Machine::OneInstruction).
+//	So is any instruction that would cause an exception: it is
+//	abandoned before it changes anything, and re-executed by the
+//	interpreter, which raises the exception just as it always has.
+//
+//	The operations are plain C++, so this works wherever the
+//	interpreter does: Nachos is built for x86-64 and 32-bit x86
+//	(build.linux), 32-bit x86 under Windows (build.cygwin), and
+//	big-endian PowerPC (build.macosx).  On an x86-64 host, a block
+//	that is run often enough (HotBlockRuns times) is also compiled
+//	into x86-64 machine code (see mipsx86.cc), which does the same
+//	thing as its operations without going through them one by one;
+//	the operations remain the fallback, for the rest of a block
+//	whenever the host code has to stop early.  Either way, every
+//	translated instruction can be checked against the interpreter
+//	(see "nachos -tc").
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef MIPSBLOCK_H
+#define MIPSBLOCK_H
+
+#include "copyright.h"
+
+const int MaxBlockLength = 32;	// most instructions translated at once
+const int HotBlockRuns = 16;	// times a block is run as operations,
+				// before it is compiled to host code
+const int NativeCodeSize = 1 << 20; // bytes of host code for hot blocks;
+				// when full, all blocks are retranslated
+
+// The operations a translated instruction can perform.  Most are
+// MIPS instructions; the rest are special cases of them.
+
+enum BlockOpType {
+    BLK_NOP,			// nothing (e.g., writes register 0)
+    BLK_LI, BLK_MOVE,		// rt = imm; rd = rs
+    BLK_ADD, BLK_ADDI, BLK_SUB,	// can overflow
+    BLK_ADDU, BLK_ADDIU, BLK_SUBU,
+    BLK_AND, BLK_ANDI, BLK_OR, BLK_ORI, BLK_XOR, BLK_XORI, BLK_NOR,
+    BLK_SLT, BLK_SLTI, BLK_SLTU, BLK_SLTIU,
+    BLK_SLL, BLK_SRL, BLK_SRA, BLK_SLLV, BLK_SRLV, BLK_SRAV,
+    BLK_MFHI, BLK_MFLO, BLK_MTHI, BLK_MTLO,
+    BLK_MULT, BLK_MULTU, BLK_DIV, BLK_DIVU,
+    BLK_LB, BLK_LBU, BLK_LH, BLK_LHU, BLK_LW,
+    BLK_SB, BLK_SH, BLK_SW,
+    BLK_BEQ, BLK_BNE, BLK_BLEZ, BLK_BGTZ, BLK_BLTZ, BLK_BGEZ,
+    BLK_BLTZAL, BLK_BGEZAL,
+    BLK_J, BLK_JAL, BLK_JR, BLK_JALR
+};
+
+// One translated instruction.
+
+class BlockOp {
+  public:
+    int pc;			// virtual address of the instruction
+    BlockOpType type;		// what to do
+    char opCode;		// the instruction's opcode, for the cost
+				// model (see Machine::SetInstructionCosts)
+    int rs, rt, rd;		// registers used
+    int imm;			// immediate value, shift amount,
+				// or branch/jump target
+
+    bool IsBranch() { return (type >= BLK_BEQ); }
+				// is it a branch or jump, and so has
+				// a delay slot?
+};
+
+// A translated block, compiled to host code: a function that runs the
+// block's instructions on "registers", and returns how many of them it
+// ran (all of them, unless it had to stop early).
+
+typedef int (*NativeBlock)(int *registers);
+
+// A translated basic block.  It is stored under the physical address
+// of its first instruction, but also remembers the virtual address,
+// since branch targets depend on it.
+
+class TranslatedBlock {
+  public:
+    int pc;			// virtual address of the first instruction
+    int length;			// number of instructions translated;
+				// 0 if the first one can't be
+    BlockOp ops[MaxBlockLength];
+    int runs;			// number of times run as operations
+    NativeBlock native;		// its host code, once it is hot (and
+				// only on an x86-64 host); else NULL
+    int ticks;			// with native: how long the block takes,
+				// not counting a taken branch
+};
+
+#endif // MIPSBLOCK_H
@@ -24,25 +24,58 @@
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 
-// The following class defines an instruction, represented in both
-// 	undecoded binary form
-//      decoded to identify
-//	    operation to do
-//	    registers to act on
-//	    any immediate operand value
-
-class Instruction {
-  public:
-    void Decode();	// decode the binary representation of the instruction
-
-    unsigned int value; // binary representation of the instruction
-
-    char opCode;     // Type of instruction.  This is NOT the same as the
-    		     // opcode field from the instruction: see defs in mips.h
-    char rs, rt, rd; // Three registers from instruction.
-    int extra;       // Immediate or target or shamt field or offset.
-                     // Immediates are sign-extended.
-};
+// There are two ways of getting from one simulated instruction to the
+// next.  By default, OneInstruction executes a single instruction via
+// a switch statement, and returns to Run, which advances the clock.
+//
+// If THREADED_DISPATCH is defined (see the Makefile), each instruction's
+// handler instead finishes its instruction, advances the clock, fetches
+// the next instruction and jumps straight to its handler (using gcc's
+// "labels as values").  Each handler thus has its own indirect branch,
+// which the host predicts much better than the single shared branch
+// of the switch.  OneInstruction then only returns to Run on an exception.
+
+#if defined(THREADED_DISPATCH) && defined(TRANSLATE_BLOCKS)
+#error "TRANSLATE_BLOCKS needs OneInstruction to run one instruction at a time"
+#endif
+
+// Charge the instruction that just finished (in "instr", going on to
+// "pcAfter") for any ticks the cost model adds to UserTick.  A branch
+// is taken if pcAfter is not the instruction after its delay slot.
+// Must come before NextPCReg is updated.
+
+#define CHARGE_TICKS()							\
+    do {								\
+	extraTicks += opExtraTicks[(int) instr->opCode];		\
+	if (pcAfter != registers[NextPCReg] + 4)			\
+	    extraTicks += takenBranchTicks;				\
+    } while (0)
+
+#ifdef THREADED_DISPATCH
+#define OPCODE(op)		case op: L_##op
+#define OPCODE_DEFAULT		default: L_default
+#define NEXT_INSTRUCTION						\
+    do {								\
+	DelayedLoad(nextLoadReg, nextLoadValue);			\
+	registers[PrevPCReg] = registers[PCReg];			\
+	registers[PCReg] = registers[NextPCReg];			\
+	CHARGE_TICKS();							\
+	registers[NextPCReg] = pcAfter;					\
+	AdvanceClock();							\
+	if (stopped)		/* end of RunAhead */			\
+	    return;							\
+	if ((instr = FetchInstruction()) == NULL)			\
+	    return;		/* Run will advance the clock */	\
+	nextLoadReg = 0;						\
+	nextLoadValue = 0;						\
+	pcAfter = registers[NextPCReg] + 4;				\
+	goto *dispatchTable[(int) instr->opCode];			\
+    } while (0)
+#else
+#define OPCODE(op)		case op
+#define OPCODE_DEFAULT		default
+#define NEXT_INSTRUCTION	break
+#endif
 
 //----------------------------------------------------------------------
 // Machine::Run
@@ -56,22 +89,157 @@ class Instruction {
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
-
     if (debug->IsEnabled('m')) {
         cout << "Starting program in thread: " << kernel->currentThread->getName();
-		cout << ", at time: " << kernel->stats->totalTicks << "\n";
+		cout << ", at time: " << stats->totalTicks << "\n";
     }
     kernel->interrupt->setStatus(UserMode);
+    UpdateHorizon();
     for (;;) {
-        OneInstruction(instr);
-		kernel->interrupt->OneTick();
-		if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
-	  		Debugger();
+#ifdef TRANSLATE_BLOCKS
+		if (RunBlock())
+		    continue;
+#endif
+        OneInstruction();
+		AdvanceClock();
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RunAhead
+// 	Run the user program whose registers and page table have been
+//	loaded into this machine, until the clock reaches "until" (or
+//	just past it, as the last instruction may take several ticks),
+//	or until an instruction needs the kernel.  That instruction is
+//	left for the kernel's machine to run.
+//
+//	Unlike Run, this returns, and never calls into the kernel, or
+//	looks at anything but this machine and the user program's memory
+//	-- so other CPUs can do the same at the same time, on other host
+//	threads (see HostCPU).  Interrupts are up to the caller: nothing
+//	may be due before "until".
+//----------------------------------------------------------------------
+
+void
+Machine::RunAhead(int until)
+{
+    runningAhead = TRUE;
+    stopped = FALSE;
+    horizon = until;
+    while (!stopped) {
+        OneInstruction();
+	if (!stopped)
+	    AdvanceClock();
+    }
+    FlushTicks();
+    runningAhead = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Machine::AdvanceClock
+// 	Advance simulated time past the user instruction just executed.
+//
+//	Interrupts can only happen when the clock reaches the time of the
+//	earliest pending interrupt (the "horizon"), so until then we
+//	just count the ticks in batchedTicks, rather than going through
+//	OneTick after every instruction.  The batched ticks are added to
+//	the statistics before anything can look at them: before calling
+//	OneTick, and before trapping to the kernel (see RaiseException).
+//	The interrupts thus fire at exactly the same ticks as before.
+//----------------------------------------------------------------------
+
+void
+Machine::AdvanceClock()
+{
+    int ticks = UserTick + extraTicks;
+
+    extraTicks = 0;
+    batchedInstructions++;
+    if (stats->totalTicks + batchedTicks + ticks < horizon) {
+	batchedTicks += ticks;
+	return;
+    }
+    if (runningAhead) {			// no OneTick: RunAhead is done
+	batchedTicks += ticks;
+	stopped = TRUE;
+	return;
+    }
+    batchedTicks += ticks - UserTick;	// OneTick adds the last UserTick
+    FlushTicks();
+    kernel->interrupt->OneTick();
+    if (singleStep && (runUntilTime <= stats->totalTicks))
+	Debugger();
+    UpdateHorizon();
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushTicks
+// 	Add the user ticks batched up by AdvanceClock to the statistics.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTicks()
+{
+    stats->totalTicks += batchedTicks;
+    stats->userTicks += batchedTicks;
+    stats->numUserInstructions += batchedInstructions;
+    batchedTicks = 0;
+    batchedInstructions = 0;
+}
+
+//----------------------------------------------------------------------
+// Machine::UpdateHorizon
+// 	Find out how far we can run before OneTick has work to do.
+//	When single stepping, or tracing interrupts (which prints 
+//	something on every tick), call OneTick after every instruction.
+//----------------------------------------------------------------------
+
+void
+Machine::UpdateHorizon()
+{
+    if (singleStep || debug->IsEnabled(dbgInt)) {
+	horizon = 0;
+    } else {
+	horizon = kernel->interrupt->Horizon();
     }
 }
 
 
+//----------------------------------------------------------------------
+// Machine::SetInstructionCosts
+// 	Set up the cost model: how many ticks of simulated time each
+//	kind of instruction takes.  By default, every instruction takes
+//	UserTick, as on the original Nachos.
+//
+//	"multiply" -- ticks for MULT and MULTU
+//	"divide" -- ticks for DIV and DIVU
+//	"memory" -- ticks for loads and stores
+//	"takenBranch" -- ticks added to a branch or jump that is taken
+//----------------------------------------------------------------------
+
+void
+Machine::SetInstructionCosts(int multiply, int divide, int memory, 
+			     int takenBranch)
+{
+    static int memoryOps[] = { OP_LB, OP_LBU, OP_LH, OP_LHU, OP_LW, OP_LWL,
+			       OP_LWR, OP_SB, OP_SH, OP_SW, OP_SWL, OP_SWR };
+
+    ASSERT(NumOpcodes == MaxOpcode + 1);
+    ASSERT(multiply >= UserTick && divide >= UserTick && memory >= UserTick);
+    ASSERT(takenBranch >= 0);
+    for (int i = 0; i < NumOpcodes; i++)
+	opExtraTicks[i] = 0;
+    opExtraTicks[OP_MULT] = opExtraTicks[OP_MULTU] = multiply - UserTick;
+    opExtraTicks[OP_DIV] = opExtraTicks[OP_DIVU] = divide - UserTick;
+    for (int i = 0; i < (int) (sizeof(memoryOps) / sizeof(int)); i++)
+	opExtraTicks[memoryOps[i]] = memory - UserTick;
+    takenBranchTicks = takenBranch;
+    extraTicks = 0;
+#ifdef TRANSLATE_BLOCKS
+    blocksStale = TRUE;		// compiled blocks have the old costs
+#endif
+}
+
 //----------------------------------------------------------------------
 // TypeToReg
 // 	Retrieve the register # referred to in an instruction. 
@@ -97,6 +265,8 @@ TypeToReg(RegType reg, Instruction *instr)
 //----------------------------------------------------------------------
 // Machine::OneInstruction
 // 	Execute one instruction from a user-level program
+//	(with THREADED_DISPATCH, keep executing instructions until
+//	one of them causes an exception)
 //
 // 	If there is any kind of exception or interrupt, we invoke the 
 //	exception handler, and when it returns, we return to Run(), which
@@ -118,43 +288,69 @@ TypeToReg(RegType reg, Instruction *instr)
 //----------------------------------------------------------------------
 
 void
-Machine::OneInstruction(Instruction *instr)
+Machine::OneInstruction()
 {
 #ifdef SIM_FIX
     int byte;       // described in Kane for LWL,LWR,...
 #endif
 
-    int raw;
+    Instruction *instr;
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
     // Fetch instruction 
-    if (!ReadMem(registers[PCReg], 4, &raw))
+    if ((instr = FetchInstruction()) == NULL)
 	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
-
-    if (debug->IsEnabled('m')) {
-        struct OpString *str = &opStrings[instr->opCode];
-	char buf[80];
-
-        ASSERT(instr->opCode <= MaxOpcode);
-        cout << "At PC = " << registers[PCReg];
-	sprintf(buf, str->format, TypeToReg(str->args[0], instr),
-	     TypeToReg(str->args[1], instr), TypeToReg(str->args[2], instr));
-        cout << "\t" << buf << "\n";
-    }
     
     // Compute next pc, but don't install in case there's an error or branch.
     int pcAfter = registers[NextPCReg] + 4;
     int sum, diff, tmp, value;
     unsigned int rs, rt, imm;
 
+#ifdef THREADED_DISPATCH
+    static void *dispatchTable[MaxOpcode + 1];
+
+    if (dispatchTable[0] == NULL) {	// first time: fill in handler addresses
+	for (int i = 0; i <= MaxOpcode; i++)
+	    dispatchTable[i] = &&L_default;
+	dispatchTable[OP_ADD] = &&L_OP_ADD;	dispatchTable[OP_ADDI] = &&L_OP_ADDI;
+	dispatchTable[OP_ADDIU] = &&L_OP_ADDIU;	dispatchTable[OP_ADDU] = &&L_OP_ADDU;
+	dispatchTable[OP_AND] = &&L_OP_AND;	dispatchTable[OP_ANDI] = &&L_OP_ANDI;
+	dispatchTable[OP_BEQ] = &&L_OP_BEQ;	dispatchTable[OP_BGEZ] = &&L_OP_BGEZ;
+	dispatchTable[OP_BGEZAL] = &&L_OP_BGEZAL; dispatchTable[OP_BGTZ] = &&L_OP_BGTZ;
+	dispatchTable[OP_BLEZ] = &&L_OP_BLEZ;	dispatchTable[OP_BLTZ] = &&L_OP_BLTZ;
+	dispatchTable[OP_BLTZAL] = &&L_OP_BLTZAL; dispatchTable[OP_BNE] = &&L_OP_BNE;
+	dispatchTable[OP_DIV] = &&L_OP_DIV;	dispatchTable[OP_DIVU] = &&L_OP_DIVU;
+	dispatchTable[OP_J] = &&L_OP_J;		dispatchTable[OP_JAL] = &&L_OP_JAL;
+	dispatchTable[OP_JALR] = &&L_OP_JALR;	dispatchTable[OP_JR] = &&L_OP_JR;
+	dispatchTable[OP_LB] = &&L_OP_LB;	dispatchTable[OP_LBU] = &&L_OP_LBU;
+	dispatchTable[OP_LH] = &&L_OP_LH;	dispatchTable[OP_LHU] = &&L_OP_LHU;
+	dispatchTable[OP_LUI] = &&L_OP_LUI;	dispatchTable[OP_LW] = &&L_OP_LW;
+	dispatchTable[OP_LWL] = &&L_OP_LWL;	dispatchTable[OP_LWR] = &&L_OP_LWR;
+	dispatchTable[OP_MFHI] = &&L_OP_MFHI;	dispatchTable[OP_MFLO] = &&L_OP_MFLO;
+	dispatchTable[OP_MTHI] = &&L_OP_MTHI;	dispatchTable[OP_MTLO] = &&L_OP_MTLO;
+	dispatchTable[OP_MULT] = &&L_OP_MULT;	dispatchTable[OP_MULTU] = &&L_OP_MULTU;
+	dispatchTable[OP_NOR] = &&L_OP_NOR;	dispatchTable[OP_OR] = &&L_OP_OR;
+	dispatchTable[OP_ORI] = &&L_OP_ORI;	dispatchTable[OP_SB] = &&L_OP_SB;
+	dispatchTable[OP_SH] = &&L_OP_SH;	dispatchTable[OP_SLL] = &&L_OP_SLL;
+	dispatchTable[OP_SLLV] = &&L_OP_SLLV;	dispatchTable[OP_SLT] = &&L_OP_SLT;
+	dispatchTable[OP_SLTI] = &&L_OP_SLTI;	dispatchTable[OP_SLTIU] = &&L_OP_SLTIU;
+	dispatchTable[OP_SLTU] = &&L_OP_SLTU;	dispatchTable[OP_SRA] = &&L_OP_SRA;
+	dispatchTable[OP_SRAV] = &&L_OP_SRAV;	dispatchTable[OP_SRL] = &&L_OP_SRL;
+	dispatchTable[OP_SRLV] = &&L_OP_SRLV;	dispatchTable[OP_SUB] = &&L_OP_SUB;
+	dispatchTable[OP_SUBU] = &&L_OP_SUBU;	dispatchTable[OP_SW] = &&L_OP_SW;
+	dispatchTable[OP_SWL] = &&L_OP_SWL;	dispatchTable[OP_SWR] = &&L_OP_SWR;
+	dispatchTable[OP_SYSCALL] = &&L_OP_SYSCALL; dispatchTable[OP_XOR] = &&L_OP_XOR;
+	dispatchTable[OP_XORI] = &&L_OP_XORI;	dispatchTable[OP_UNIMP] = &&L_OP_UNIMP;
+	dispatchTable[OP_RES] = &&L_OP_RES;
+    }
+#endif
+
     // Execute the instruction (cf. Kane's book)
     switch (instr->opCode) {
 	
-      case OP_ADD:
+      OPCODE(OP_ADD):
 	sum = registers[instr->rs] + registers[instr->rt];
 	if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
 	    ((registers[instr->rs] ^ sum) & SIGN_BIT)) {
@@ -162,9 +358,9 @@ Machine::OneInstruction(Instruction *instr)
 	    return;
 	}
 	registers[instr->rd] = sum;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_ADDI:
+      OPCODE(OP_ADDI):
 	sum = registers[instr->rs] + instr->extra;
 	if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT) &&
 	    ((instr->extra ^ sum) & SIGN_BIT)) {
@@ -172,59 +368,59 @@ Machine::OneInstruction(Instruction *instr)
 	    return;
 	}
 	registers[instr->rt] = sum;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_ADDIU:
+      OPCODE(OP_ADDIU):
 	registers[instr->rt] = registers[instr->rs] + instr->extra;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_ADDU:
+      OPCODE(OP_ADDU):
 	registers[instr->rd] = registers[instr->rs] + registers[instr->rt];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_AND:
+      OPCODE(OP_AND):
 	registers[instr->rd] = registers[instr->rs] & registers[instr->rt];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_ANDI:
+      OPCODE(OP_ANDI):
 	registers[instr->rt] = registers[instr->rs] & (instr->extra & 0xffff);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_BEQ:
+      OPCODE(OP_BEQ):
 	if (registers[instr->rs] == registers[instr->rt])
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_BGEZAL:
+      OPCODE(OP_BGEZAL):
 	registers[R31] = registers[NextPCReg] + 4;
-      case OP_BGEZ:
+      OPCODE(OP_BGEZ):
 	if (!(registers[instr->rs] & SIGN_BIT))
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_BGTZ:
+      OPCODE(OP_BGTZ):
 	if (registers[instr->rs] > 0)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_BLEZ:
+      OPCODE(OP_BLEZ):
 	if (registers[instr->rs] <= 0)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_BLTZAL:
+      OPCODE(OP_BLTZAL):
 	registers[R31] = registers[NextPCReg] + 4;
-      case OP_BLTZ:
+      OPCODE(OP_BLTZ):
 	if (registers[instr->rs] & SIGN_BIT)
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_BNE:
+      OPCODE(OP_BNE):
 	if (registers[instr->rs] != registers[instr->rt])
 	    pcAfter = registers[NextPCReg] + IndexToAddr(instr->extra);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_DIV:
+      OPCODE(OP_DIV):
 	if (registers[instr->rt] == 0) {
 	    registers[LoReg] = 0;
 	    registers[HiReg] = 0;
@@ -232,9 +428,9 @@ Machine::OneInstruction(Instruction *instr)
 	    registers[LoReg] =  registers[instr->rs] / registers[instr->rt];
 	    registers[HiReg] = registers[instr->rs] % registers[instr->rt];
 	}
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_DIVU:	  
+      OPCODE(OP_DIVU):	  
 	  rs = (unsigned int) registers[instr->rs];
 	  rt = (unsigned int) registers[instr->rt];
 	  if (rt == 0) {
@@ -246,22 +442,22 @@ Machine::OneInstruction(Instruction *instr)
 	      tmp = rs % rt;
 	      registers[HiReg] = (int) tmp;
 	  }
-	  break;
+	  NEXT_INSTRUCTION;
 	
-      case OP_JAL:
+      OPCODE(OP_JAL):
 	registers[R31] = registers[NextPCReg] + 4;
-      case OP_J:
+      OPCODE(OP_J):
 	pcAfter = (pcAfter & 0xf0000000) | IndexToAddr(instr->extra);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_JALR:
+      OPCODE(OP_JALR):
 	registers[instr->rd] = registers[NextPCReg] + 4;
-      case OP_JR:
+      OPCODE(OP_JR):
 	pcAfter = registers[instr->rs];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_LB:
-      case OP_LBU:
+      OPCODE(OP_LB):
+      OPCODE(OP_LBU):
 	tmp = registers[instr->rs] + instr->extra;
 	if (!ReadMem(tmp, 1, &value))
 	    return;
@@ -272,10 +468,10 @@ Machine::OneInstruction(Instruction *instr)
 	    value &= 0xff;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_LH:
-      case OP_LHU:	  
+      OPCODE(OP_LH):
+      OPCODE(OP_LHU):	  
 	tmp = registers[instr->rs] + instr->extra;
 	if (tmp & 0x1) {
 	    RaiseException(AddressErrorException, tmp);
@@ -290,14 +486,14 @@ Machine::OneInstruction(Instruction *instr)
 	    value &= 0xffff;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
-	break;
+	NEXT_INSTRUCTION;
       	
-      case OP_LUI:
+      OPCODE(OP_LUI):
 	DEBUG(dbgMach, "Executing: LUI r" << instr->rt << ", " << instr->extra);
 	registers[instr->rt] = instr->extra << 16;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_LW:
+      OPCODE(OP_LW):
 	tmp = registers[instr->rs] + instr->extra;
 	if (tmp & 0x3) {
 	    RaiseException(AddressErrorException, tmp);
@@ -307,9 +503,9 @@ Machine::OneInstruction(Instruction *instr)
 	    return;
 	nextLoadReg = instr->rt;
 	nextLoadValue = value;
-	break;
+	NEXT_INSTRUCTION;
     	
-      case OP_LWL:	  
+      OPCODE(OP_LWL):	  
 	tmp = registers[instr->rs] + instr->extra;
 
 #ifdef SIM_FIX
@@ -359,9 +555,9 @@ Machine::OneInstruction(Instruction *instr)
 	    break;
 	}
 	nextLoadReg = instr->rt;
-	break;
+	NEXT_INSTRUCTION;
       	
-      case OP_LWR:
+      OPCODE(OP_LWR):
 	tmp = registers[instr->rs] + instr->extra;
 
 #ifdef SIM_FIX
@@ -415,121 +611,121 @@ Machine::OneInstruction(Instruction *instr)
 	    break;
 	}
 	nextLoadReg = instr->rt;
-	break;
+	NEXT_INSTRUCTION;
     	
-      case OP_MFHI:
+      OPCODE(OP_MFHI):
 	registers[instr->rd] = registers[HiReg];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_MFLO:
+      OPCODE(OP_MFLO):
 	registers[instr->rd] = registers[LoReg];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_MTHI:
+      OPCODE(OP_MTHI):
 	registers[HiReg] = registers[instr->rs];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_MTLO:
+      OPCODE(OP_MTLO):
 	registers[LoReg] = registers[instr->rs];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_MULT:
+      OPCODE(OP_MULT):
 	Mult(registers[instr->rs], registers[instr->rt], TRUE,
 	     &registers[HiReg], &registers[LoReg]);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_MULTU:
+      OPCODE(OP_MULTU):
 	Mult(registers[instr->rs], registers[instr->rt], FALSE,
 	     &registers[HiReg], &registers[LoReg]);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_NOR:
+      OPCODE(OP_NOR):
 	registers[instr->rd] = ~(registers[instr->rs] | registers[instr->rt]);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_OR:
+      OPCODE(OP_OR):
 	registers[instr->rd] = registers[instr->rs] | registers[instr->rt];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_ORI:
+      OPCODE(OP_ORI):
 	registers[instr->rt] = registers[instr->rs] | (instr->extra & 0xffff);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SB:
+      OPCODE(OP_SB):
 	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 1, registers[instr->rt]))
 	    return;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SH:
+      OPCODE(OP_SH):
 	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 2, registers[instr->rt]))
 	    return;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SLL:
+      OPCODE(OP_SLL):
 	registers[instr->rd] = registers[instr->rt] << instr->extra;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SLLV:
+      OPCODE(OP_SLLV):
 	registers[instr->rd] = registers[instr->rt] <<
 	    (registers[instr->rs] & 0x1f);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SLT:
+      OPCODE(OP_SLT):
 	if (registers[instr->rs] < registers[instr->rt])
 	    registers[instr->rd] = 1;
 	else
 	    registers[instr->rd] = 0;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SLTI:
+      OPCODE(OP_SLTI):
 	if (registers[instr->rs] < instr->extra)
 	    registers[instr->rt] = 1;
 	else
 	    registers[instr->rt] = 0;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SLTIU:	  
+      OPCODE(OP_SLTIU):	  
 	rs = registers[instr->rs];
 	imm = instr->extra;
 	if (rs < imm)
 	    registers[instr->rt] = 1;
 	else
 	    registers[instr->rt] = 0;
-	break;
+	NEXT_INSTRUCTION;
       	
-      case OP_SLTU:	  
+      OPCODE(OP_SLTU):	  
 	rs = registers[instr->rs];
 	rt = registers[instr->rt];
 	if (rs < rt)
 	    registers[instr->rd] = 1;
 	else
 	    registers[instr->rd] = 0;
-	break;
+	NEXT_INSTRUCTION;
       	
-      case OP_SRA:
+      OPCODE(OP_SRA):
 	registers[instr->rd] = registers[instr->rt] >> instr->extra;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SRAV:
+      OPCODE(OP_SRAV):
 	registers[instr->rd] = registers[instr->rt] >>
 	    (registers[instr->rs] & 0x1f);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SRL:
+      OPCODE(OP_SRL):
 	tmp = registers[instr->rt];
 	tmp >>= instr->extra;
 	registers[instr->rd] = tmp;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SRLV:
+      OPCODE(OP_SRLV):
 	tmp = registers[instr->rt];
 	tmp >>= (registers[instr->rs] & 0x1f);
 	registers[instr->rd] = tmp;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SUB:	  
+      OPCODE(OP_SUB):	  
 	diff = registers[instr->rs] - registers[instr->rt];
 	if (((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT) &&
 	    ((registers[instr->rs] ^ diff) & SIGN_BIT)) {
@@ -537,19 +733,19 @@ Machine::OneInstruction(Instruction *instr)
 	    return;
 	}
 	registers[instr->rd] = diff;
-	break;
+	NEXT_INSTRUCTION;
       	
-      case OP_SUBU:
+      OPCODE(OP_SUBU):
 	registers[instr->rd] = registers[instr->rs] - registers[instr->rt];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SW:
+      OPCODE(OP_SW):
 	if (!WriteMem((unsigned) 
 		(registers[instr->rs] + instr->extra), 4, registers[instr->rt]))
 	    return;
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_SWL:	  
+      OPCODE(OP_SWL):	  
 	tmp = registers[instr->rs] + instr->extra;
 
 #ifdef SIM_FIX
@@ -606,9 +802,9 @@ Machine::OneInstruction(Instruction *instr)
         if (!WriteMem((tmp - byte), 4, value))
             return;
 #endif // SIM_FIX
-	break;
+	NEXT_INSTRUCTION;
     	
-      case OP_SWR:	  
+      OPCODE(OP_SWR):	  
 	tmp = registers[instr->rs] + instr->extra;
 
 #ifndef SIM_FIX
@@ -665,26 +861,26 @@ Machine::OneInstruction(Instruction *instr)
 #endif // SIM_FIX
 
 
-	break;
+	NEXT_INSTRUCTION;
     	
-      case OP_SYSCALL:
+      OPCODE(OP_SYSCALL):
 	RaiseException(SyscallException, 0);
 	return; 
 	
-      case OP_XOR:
+      OPCODE(OP_XOR):
 	registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_XORI:
+      OPCODE(OP_XORI):
 	registers[instr->rt] = registers[instr->rs] ^ (instr->extra & 0xffff);
-	break;
+	NEXT_INSTRUCTION;
 	
-      case OP_RES:
-      case OP_UNIMP:
+      OPCODE(OP_RES):
+      OPCODE(OP_UNIMP):
 	RaiseException(IllegalInstrException, 0);
 	return;
 	
-      default:
+      OPCODE_DEFAULT:
 	ASSERT(FALSE);
     }
     
@@ -697,6 +893,7 @@ Machine::OneInstruction(Instruction *instr)
     registers[PrevPCReg] = registers[PCReg];	// for debugging, in case we
 						// are jumping into lala-land
     registers[PCReg] = registers[NextPCReg];
+    CHARGE_TICKS();
     registers[NextPCReg] = pcAfter;
 }
 
@@ -717,6 +914,72 @@ Machine::DelayedLoad(int nextReg, int nextValue)
     registers[0] = 0; 	// and always make sure R0 stays zero.
 }
 
+//----------------------------------------------------------------------
+// Machine::FetchInstruction
+// 	Return the decoded form of the instruction at the current PC,
+//	or NULL if the fetch caused an exception.
+//
+//	The word is only decoded the first time it is fetched;
+//	afterwards the copy in decodeCache is used, until the word is
+//	overwritten (see WriteMem and InvalidateCode).
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::FetchInstruction()
+{
+    ExceptionType exception;
+    int physicalAddress;
+    char *hostAddress;
+    Instruction *instr;
+
+    DEBUG(dbgAddr, "Fetching VA " << registers[PCReg]);
+    hostAddress = SoftTranslate(registers[PCReg], 4, FALSE);
+    if (hostAddress == NULL) {
+	exception = Translate(registers[PCReg], &physicalAddress, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, registers[PCReg]);
+	    return NULL;
+	}
+	hostAddress = &mainMemory[physicalAddress];
+    }
+    if (icache != NULL)
+	extraTicks += icache->Access(hostAddress - mainMemory);
+    if (profileCounts != NULL)
+	profileCounts[(hostAddress - mainMemory) >> 2]++;
+    instr = DecodeWord(hostAddress - mainMemory);
+
+    if (debug->IsEnabled('m')) {
+        struct OpString *str = &opStrings[instr->opCode];
+	char buf[80];
+
+        ASSERT(instr->opCode <= MaxOpcode);
+        cout << "At PC = " << registers[PCReg];
+	sprintf(buf, str->format, TypeToReg(str->args[0], instr),
+	     TypeToReg(str->args[1], instr), TypeToReg(str->args[2], instr));
+        cout << "\t" << buf << "\n";
+    }
+    return instr;
+}
+
+//----------------------------------------------------------------------
+// Machine::DecodeWord
+// 	Return the decoded form of the word at physical address
+//	"physAddr", decoding it if it isn't in decodeCache yet.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::DecodeWord(int physAddr)
+{
+    Instruction *instr = &decodeCache[physAddr >> 2];
+
+    if (!instr->decoded) {
+	instr->value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	instr->Decode();
+	instr->decoded = TRUE;
+    }
+    return instr;
+}
+
 //----------------------------------------------------------------------
 // Instruction::Decode
 // 	Decode a MIPS instruction 
@@ -114,6 +114,8 @@ struct OpInfo {
     int format;		/* Format type (IFMT or JFMT or RFMT) */
 };
 
+#ifndef MIPSSIM_OPCODES_ONLY	/* the tables are only for mipssim.cc */
+
 static OpInfo opTable[] = {
     {SPECIAL, RFMT}, {BCOND, IFMT}, {OP_J, JFMT}, {OP_JAL, JFMT},
     {OP_BEQ, IFMT}, {OP_BNE, IFMT}, {OP_BLEZ, IFMT}, {OP_BGTZ, IFMT},
@@ -226,4 +228,6 @@ static struct OpString opStrings[] = {
 	{"Reserved", {NONE, NONE, NONE}}
       };
 
+#endif // MIPSSIM_OPCODES_ONLY
+
 #endif // MIPSSIM_H
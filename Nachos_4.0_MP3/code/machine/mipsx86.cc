@@ -0,0 +1,745 @@
+// mipsx86.cc -- compile hot translated blocks (see mipsblock.h) into
+//	x86-64 machine code, and run it.
+//
+//   The code for a block does, instruction by instruction, exactly what
+//   Machine::RunBlockOp does for its operations, with the registers,
+//   immediates and addresses built in.  The simulated registers stay in
+//   memory ("registers", addressed from %rbx), so the code can stop
+//   before any instruction with the machine in the same state the
+//   operations would leave it in: whenever an instruction would cause
+//   an exception, miss in the soft TLB, or overwrite predecoded code,
+//   the code returns how many instructions it did, and RunBlock runs
+//   that one (and the rest of the block) as operations instead.
+//
+//   The program counters are only written when the code stops, or
+//   at the branch; delayed loads are done in place, as DelayedLoad
+//   would, but only where one is pending.
+//
+//   Only compiled in if TRANSLATE_BLOCKS is defined, on an x86-64 host.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+#if defined(TRANSLATE_BLOCKS) && defined(x86_64)
+
+#include <stddef.h>
+#include "debug.h"
+#include "machine.h"
+#include "main.h"
+
+// The host registers the code uses.  Arithmetic is done in the low
+// 32 bits of RAX, RCX, RDX and RSI; the rest hold addresses for the
+// whole block.
+
+enum HostReg {
+    RAX = 0, RCX = 1, RDX = 2,
+    RBX = 3,			// the simulated registers
+    RSI = 6,			// the PC after a branch
+    R12 = 12,			// decodeCache
+    R13 = 13,			// softTLB
+    R14 = 14			// mainMemory
+};
+
+// Condition codes, for Jcc, SETcc and CMOVcc.
+
+enum HostCond {
+    CondO = 0x0, CondB = 0x2, CondE = 0x4, CondNE = 0x5,
+    CondS = 0x8, CondNS = 0x9, CondL = 0xc, CondLE = 0xe, CondG = 0xf,
+    CondAlways = -1
+};
+
+const int MaxNativeBlockSize = 8192;	// bytes of code for one block
+const int MaxBlockExits = 4 * MaxBlockLength;	// ways for it to stop
+
+// How much of a pending delayed load the code knows about, before
+// each instruction.
+
+const int PendingUnknown = -1;		// (at the start of the block)
+const int NoPending = -2;		// LoadReg and LoadValueReg are 0;
+					// otherwise, the register to load
+
+// Where a simulated register is, relative to %rbx.
+
+#define REG(r)	((r) * (int) sizeof(int))
+
+// The code for one block, as it is generated.
+
+class X86Code {
+  public:
+    X86Code(char *buffer) { start = next = buffer; numExits = 0; }
+
+    char *start;		// the first byte
+    char *next;			// where the next one goes
+
+    int exitAt[MaxBlockExits];	// jumps to where the code stops,
+    int exitBefore[MaxBlockExits];	// and before which instruction
+    int numExits;
+
+    int Size() { return next - start; }
+
+    void Byte(int b) { *next++ = (char) b; }
+    void Word(int w) { *(int *) next = w; next += 4; }
+    void Quad(long q) { *(long *) next = q; next += 8; }
+
+    void Rex(bool wide, int reg, int base);
+    void Opcode(int opcode, bool wide, int reg, int base);
+    void Mem(int opcode, int reg, int base, int disp, bool wide = FALSE);
+    void Reg(int opcode, int reg, int rm, bool wide = FALSE);
+
+    int Jump(int cond);		// jump to be patched; return where
+    void Patch(int at) { *(int *) (start + at) = Size() - (at + 4); }
+    void Exit(int cond, int before);
+				// jump to where the code stops, before
+				// instruction "before"
+
+    // shorthands for moving the simulated registers
+    void Load(int reg, int r) { Mem(0x8b, reg, RBX, REG(r)); }
+    void Store(int r, int reg) { Mem(0x89, reg, RBX, REG(r)); }
+    void Set(int r, int value) { Mem(0xc7, 0, RBX, REG(r)); Word(value); }
+    void MovImm(int reg, int value) { Byte(0xb8 + reg); Word(value); }
+    void AluImm(int ext, int reg, int value)
+			{ Reg(0x81, ext, reg); Word(value); }
+};
+
+//----------------------------------------------------------------------
+// X86Code::Rex, X86Code::Opcode
+// 	Emit an instruction's REX prefix, if it needs one (for a 64-bit
+//	operand, or one of R8-R15), and then its one or two opcode bytes.
+//----------------------------------------------------------------------
+
+void
+X86Code::Rex(bool wide, int reg, int base)
+{
+    int rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0)
+		   | ((base & 8) ? 1 : 0);
+
+    if (rex != 0x40) {
+	Byte(rex);
+    }
+}
+
+void
+X86Code::Opcode(int opcode, bool wide, int reg, int base)
+{
+    Rex(wide, reg, base);
+    if (opcode > 0xff) {
+	Byte(opcode >> 8);
+    }
+    Byte(opcode & 0xff);
+}
+
+//----------------------------------------------------------------------
+// X86Code::Mem
+// 	Emit an instruction whose operands are host register (or opcode
+//	extension) "reg", and memory at "disp" bytes from "base".
+//----------------------------------------------------------------------
+
+void
+X86Code::Mem(int opcode, int reg, int base, int disp, bool wide)
+{
+    bool shortDisp = (disp >= -128 && disp < 128);
+
+    Opcode(opcode, wide, reg, base);
+    Byte((shortDisp ? 0x40 : 0x80) | ((reg & 7) << 3) | (base & 7));
+    if ((base & 7) == 4) {	// RSP or R12: needs a SIB byte
+	Byte(0x24);
+    }
+    if (shortDisp) {
+	Byte(disp);
+    } else {
+	Word(disp);
+    }
+}
+
+//----------------------------------------------------------------------
+// X86Code::Reg
+// 	Emit an instruction whose operands are host registers (or an
+//	opcode extension) "reg" and "rm".
+//----------------------------------------------------------------------
+
+void
+X86Code::Reg(int opcode, int reg, int rm, bool wide)
+{
+    Opcode(opcode, wide, reg, rm);
+    Byte(0xc0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+//----------------------------------------------------------------------
+// X86Code::Jump
+// 	Emit a jump, taken if "cond" holds (or always), whose target is
+//	filled in later by Patch.  Returns where the target goes.
+//----------------------------------------------------------------------
+
+int
+X86Code::Jump(int cond)
+{
+    if (cond == CondAlways) {
+	Byte(0xe9);
+    } else {
+	Byte(0x0f);
+	Byte(0x80 + cond);
+    }
+    Word(0);
+    return Size() - 4;
+}
+
+//----------------------------------------------------------------------
+// X86Code::Exit
+// 	Emit a jump, taken if "cond" holds, out of the block, leaving
+//	instruction "before" and the rest to the operations.
+//----------------------------------------------------------------------
+
+void
+X86Code::Exit(int cond, int before)
+{
+    ASSERT(numExits < MaxBlockExits);
+    exitAt[numExits] = Jump(cond);
+    exitBefore[numExits] = before;
+    numExits++;
+}
+
+//----------------------------------------------------------------------
+// IsLoad
+// 	Return TRUE if the operation is a (delayed) load.
+//----------------------------------------------------------------------
+
+static bool
+IsLoad(BlockOp *op)
+{
+    return (op->type >= BLK_LB && op->type <= BLK_LW);
+}
+
+//----------------------------------------------------------------------
+// WritesZero
+// 	Return TRUE if the operation sets register 0 (which must then be
+//	cleared, as at the end of every instruction).  Most operations
+//	that would are already BLK_NOP.
+//----------------------------------------------------------------------
+
+static bool
+WritesZero(BlockOp *op)
+{
+    switch (op->type) {
+      case BLK_ADD: case BLK_SUB: case BLK_JALR:
+	return (op->rd == 0);
+      case BLK_ADDI:
+	return (op->rt == 0);
+      default:
+	return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// EmitAddress
+// 	Emit the code to find the host address of a load or store of
+//	"size" bytes, like SoftTranslate, and leave it in %rdx; stop
+//	before instruction "index" if SoftTranslate would return NULL.
+//----------------------------------------------------------------------
+
+static void
+EmitAddress(X86Code *x, BlockOp *op, int index, int size, bool writing)
+{
+    int pageShift = 0;
+
+    while ((1 << pageShift) < PageSize) {
+	pageShift++;
+    }
+    ASSERT((1 << pageShift) == PageSize);
+    ASSERT((SoftTLBSize & (SoftTLBSize - 1)) == 0);
+
+    x->Load(RAX, op->rs);			// eax = virtual address
+    if (op->imm != 0) {
+	x->AluImm(0, RAX, op->imm);		// add
+    }
+    if (size > 1) {				// misaligned?
+	x->Byte(0xa9);				// test eax, size - 1
+	x->Word(size - 1);
+	x->Exit(CondNE, index);
+    }
+    x->Reg(0x8b, RCX, RAX);			// ecx = virtual page
+    x->Reg(0xc1, 5, RCX);			// shr
+    x->Byte(pageShift);
+    x->Reg(0x8b, RDX, RCX);			// rdx = &softTLB[ecx % size]
+    x->AluImm(4, RDX, SoftTLBSize - 1);		// and
+    x->Reg(0x69, RDX, RDX);			// imul
+    x->Word(sizeof(SoftTLBEntry));
+    x->Reg(0x01, R13, RDX, TRUE);		// add
+    x->Mem(0x39, RCX, RDX, offsetof(SoftTLBEntry, virtualPage));
+    x->Exit(CondNE, index);			// not cached
+    if (writing) {
+	x->Mem(0x80, 7, RDX, offsetof(SoftTLBEntry, writable));
+	x->Byte(0);				// cmp byte
+	x->Exit(CondE, index);			// not writable (yet)
+    }
+    x->Mem(0x8b, RDX, RDX, offsetof(SoftTLBEntry, page), TRUE);
+    x->AluImm(4, RAX, PageSize - 1);		// and
+    x->Reg(0x01, RAX, RDX, TRUE);		// add rdx, rax
+}
+
+//----------------------------------------------------------------------
+// EmitOp
+// 	Emit the code for one translated instruction, "index" in its
+//	block, up to but not including the delayed load and the program
+//	counters.  A load leaves the value loaded in %eax; a branch or
+//	jump leaves the PC it goes to in %esi.
+//----------------------------------------------------------------------
+
+static void
+EmitOp(X86Code *x, BlockOp *op, int index)
+{
+    int patch, done;
+
+    switch (op->type) {
+      case BLK_NOP:
+	break;
+      case BLK_LI:
+	x->Set(op->rt, op->imm);
+	break;
+      case BLK_MOVE:
+	x->Load(RAX, op->rs);
+	x->Store(op->rd, RAX);
+	break;
+
+      case BLK_ADD:				// these stop on overflow
+      case BLK_SUB:
+	x->Load(RAX, op->rs);
+	x->Mem(op->type == BLK_ADD ? 0x03 : 0x2b, RAX, RBX, REG(op->rt));
+	x->Exit(CondO, index);
+	x->Store(op->rd, RAX);
+	break;
+      case BLK_ADDI:
+	x->Load(RAX, op->rs);
+	x->AluImm(0, RAX, op->imm);
+	x->Exit(CondO, index);
+	x->Store(op->rt, RAX);
+	break;
+
+      case BLK_ADDU: case BLK_SUBU: case BLK_AND: case BLK_OR:
+      case BLK_XOR: case BLK_NOR:
+	x->Load(RAX, op->rs);
+	switch (op->type) {
+	  case BLK_ADDU: x->Mem(0x03, RAX, RBX, REG(op->rt)); break;
+	  case BLK_SUBU: x->Mem(0x2b, RAX, RBX, REG(op->rt)); break;
+	  case BLK_AND:  x->Mem(0x23, RAX, RBX, REG(op->rt)); break;
+	  case BLK_XOR:  x->Mem(0x33, RAX, RBX, REG(op->rt)); break;
+	  default:	 x->Mem(0x0b, RAX, RBX, REG(op->rt)); break;
+	}
+	if (op->type == BLK_NOR) {
+	    x->Reg(0xf7, 2, RAX);		// not
+	}
+	x->Store(op->rd, RAX);
+	break;
+      case BLK_ADDIU: case BLK_ANDI: case BLK_ORI: case BLK_XORI:
+	x->Load(RAX, op->rs);
+	switch (op->type) {
+	  case BLK_ADDIU: x->AluImm(0, RAX, op->imm); break;
+	  case BLK_ANDI:  x->AluImm(4, RAX, op->imm); break;
+	  case BLK_ORI:   x->AluImm(1, RAX, op->imm); break;
+	  default:	  x->AluImm(6, RAX, op->imm); break;
+	}
+	x->Store(op->rt, RAX);
+	break;
+
+      case BLK_SLT: case BLK_SLTU:
+	x->Load(RAX, op->rs);
+	x->Mem(0x3b, RAX, RBX, REG(op->rt));	// cmp
+	x->Reg(0x0f90 + (op->type == BLK_SLT ? CondL : CondB), 0, RAX);
+	x->Reg(0x0fb6, RAX, RAX);		// movzx eax, al
+	x->Store(op->rd, RAX);
+	break;
+      case BLK_SLTI: case BLK_SLTIU:
+	x->Load(RAX, op->rs);
+	x->AluImm(7, RAX, op->imm);		// cmp
+	x->Reg(0x0f90 + (op->type == BLK_SLTI ? CondL : CondB), 0, RAX);
+	x->Reg(0x0fb6, RAX, RAX);
+	x->Store(op->rt, RAX);
+	break;
+
+      case BLK_SLL: case BLK_SRL: case BLK_SRA:
+	x->Load(RAX, op->rt);			// SRL is arithmetic, as
+	x->Reg(0xc1, (op->type == BLK_SLL) ? 4 : 7, RAX);  // in RunBlockOp
+	x->Byte(op->imm);
+	x->Store(op->rd, RAX);
+	break;
+      case BLK_SLLV: case BLK_SRLV: case BLK_SRAV:
+	x->Load(RCX, op->rs);			// the shift masks %cl
+	x->Load(RAX, op->rt);
+	x->Reg(0xd3, (op->type == BLK_SLLV) ? 4 : 7, RAX);
+	x->Store(op->rd, RAX);
+	break;
+
+      case BLK_MFHI:
+	x->Load(RAX, HiReg);
+	x->Store(op->rd, RAX);
+	break;
+      case BLK_MFLO:
+	x->Load(RAX, LoReg);
+	x->Store(op->rd, RAX);
+	break;
+      case BLK_MTHI:
+	x->Load(RAX, op->rs);
+	x->Store(HiReg, RAX);
+	break;
+      case BLK_MTLO:
+	x->Load(RAX, op->rs);
+	x->Store(LoReg, RAX);
+	break;
+      case BLK_MULT: case BLK_MULTU:
+	if (op->type == BLK_MULT) {		// sign- or zero-extend
+	    x->Mem(0x63, RAX, RBX, REG(op->rs), TRUE);	// movsxd
+	    x->Mem(0x63, RCX, RBX, REG(op->rt), TRUE);
+	} else {
+	    x->Load(RAX, op->rs);
+	    x->Load(RCX, op->rt);
+	}
+	x->Reg(0x0faf, RAX, RCX, TRUE);		// imul rax, rcx
+	x->Store(LoReg, RAX);
+	x->Reg(0xc1, 5, RAX, TRUE);		// shr rax, 32
+	x->Byte(32);
+	x->Store(HiReg, RAX);
+	break;
+      case BLK_DIV: case BLK_DIVU:
+	x->Load(RCX, op->rt);
+	x->Reg(0x85, RCX, RCX);			// test
+	patch = x->Jump(CondE);
+	x->Load(RAX, op->rs);
+	if (op->type == BLK_DIV) {
+	    x->Byte(0x99);			// cdq
+	    x->Reg(0xf7, 7, RCX);		// idiv
+	} else {
+	    x->Reg(0x31, RDX, RDX);		// xor
+	    x->Reg(0xf7, 6, RCX);		// div
+	}
+	x->Store(LoReg, RAX);
+	x->Store(HiReg, RDX);
+	done = x->Jump(CondAlways);
+	x->Patch(patch);			// divide by zero
+	x->Set(LoReg, 0);
+	x->Set(HiReg, 0);
+	x->Patch(done);
+	break;
+
+      case BLK_LB: case BLK_LBU:
+	EmitAddress(x, op, index, 1, FALSE);
+	x->Mem(op->type == BLK_LB ? 0x0fbe : 0x0fb6, RAX, RDX, 0);
+	break;
+      case BLK_LH: case BLK_LHU:
+	EmitAddress(x, op, index, 2, FALSE);
+	x->Mem(op->type == BLK_LH ? 0x0fbf : 0x0fb7, RAX, RDX, 0);
+	break;
+      case BLK_LW:
+	EmitAddress(x, op, index, 4, FALSE);
+	x->Mem(0x8b, RAX, RDX, 0);
+	break;
+
+      case BLK_SB: case BLK_SH: case BLK_SW:
+	EmitAddress(x, op, index, (op->type == BLK_SB) ? 1
+				  : (op->type == BLK_SH) ? 2 : 4, TRUE);
+	// rcx = &decodeCache[(rdx - mainMemory) / 4]; stop if the
+	// word has been decoded, so the operation can invalidate it
+	x->Reg(0x8b, RCX, RDX, TRUE);
+	x->Reg(0x29, R14, RCX, TRUE);		// sub
+	x->Reg(0xc1, 5, RCX, TRUE);		// shr
+	x->Byte(2);
+	x->Reg(0x69, RCX, RCX, TRUE);		// imul
+	x->Word(sizeof(Instruction));
+	x->Reg(0x01, R12, RCX, TRUE);		// add
+	x->Mem(0x80, 7, RCX, offsetof(Instruction, decoded));
+	x->Byte(0);				// cmp byte
+	x->Exit(CondNE, index);
+	x->Load(RCX, op->rt);
+	if (op->type == BLK_SB) {
+	    x->Mem(0x88, RCX, RDX, 0);		// mov byte
+	} else if (op->type == BLK_SH) {
+	    x->Byte(0x66);			// mov word
+	    x->Mem(0x89, RCX, RDX, 0);
+	} else {
+	    x->Mem(0x89, RCX, RDX, 0);
+	}
+	break;
+
+      case BLK_BEQ: case BLK_BNE:
+	x->Load(RAX, op->rs);
+	x->Mem(0x3b, RAX, RBX, REG(op->rt));	// cmp
+	x->MovImm(RSI, op->pc + 8);
+	x->MovImm(RCX, op->imm);
+	x->Reg(0x0f40 + (op->type == BLK_BEQ ? CondE : CondNE), RSI, RCX);
+	break;					// cmov
+      case BLK_BLEZ: case BLK_BGTZ: case BLK_BLTZ: case BLK_BGEZ:
+      case BLK_BLTZAL: case BLK_BGEZAL:
+	if (op->type == BLK_BLTZAL || op->type == BLK_BGEZAL) {
+	    x->Set(RetAddrReg, op->pc + 8);		// first, as in RunBlockOp
+	}
+	x->Load(RAX, op->rs);
+	x->Reg(0x85, RAX, RAX);			// test
+	x->MovImm(RSI, op->pc + 8);
+	x->MovImm(RCX, op->imm);
+	switch (op->type) {
+	  case BLK_BLEZ: x->Reg(0x0f40 + CondLE, RSI, RCX); break;
+	  case BLK_BGTZ: x->Reg(0x0f40 + CondG, RSI, RCX); break;
+	  case BLK_BLTZ: case BLK_BLTZAL:
+	    x->Reg(0x0f40 + CondS, RSI, RCX);
+	    break;
+	  default:	 x->Reg(0x0f40 + CondNS, RSI, RCX); break;
+	}
+	break;
+      case BLK_J: case BLK_JAL:
+	if (op->type == BLK_JAL) {
+	    x->Set(RetAddrReg, op->pc + 8);
+	}
+	x->MovImm(RSI, op->imm);
+	break;
+      case BLK_JR: case BLK_JALR:
+	if (op->type == BLK_JALR) {
+	    x->Set(op->rd, op->pc + 8);
+	}
+	x->Load(RSI, op->rs);
+	break;
+
+      default:
+	ASSERT(FALSE);
+    }
+}
+
+//----------------------------------------------------------------------
+// EmitPCs
+// 	Emit the code to set the program counters as they are after
+//	the (straight-line) instruction at virtual address "pc".
+//----------------------------------------------------------------------
+
+static void
+EmitPCs(X86Code *x, int pc)
+{
+    x->Set(PrevPCReg, pc);
+    x->Set(PCReg, pc + 4);
+    x->Set(NextPCReg, pc + 8);
+}
+
+//----------------------------------------------------------------------
+// Machine::CompileBlock
+// 	Generate host code for a translated block, in nativeCode, and
+//	return it; or return NULL if nativeCode is full (in which case,
+//	all blocks are thrown away, to start again).
+//
+//	The code is a function of "registers" (this machine's), which
+//	also has this machine's decodeCache, softTLB and mainMemory
+//	built in.
+//----------------------------------------------------------------------
+
+NativeBlock
+Machine::CompileBlock(TranslatedBlock *block)
+{
+    bool pcsStored[MaxBlockLength + 1]; // are the PCs in "registers"
+					// up to date, before each one?
+    int pending = PendingUnknown;
+    int epilogue, i;
+
+    if (nativeUsed + MaxNativeBlockSize > NativeCodeSize) {
+	blocksStale = TRUE;
+	return NULL;
+    }
+    X86Code x(nativeCode + nativeUsed);
+
+    x.Byte(0x53);				// push rbx
+    x.Byte(0x41); x.Byte(0x54);			// push r12
+    x.Byte(0x41); x.Byte(0x55);			// push r13
+    x.Byte(0x41); x.Byte(0x56);			// push r14
+    x.Reg(0x89, 7, RBX, TRUE);			// mov rbx, rdi
+    x.Opcode(0xb8 + (R12 & 7), TRUE, 0, R12);	// mov r12, decodeCache
+    x.Quad((long) decodeCache);
+    x.Opcode(0xb8 + (R13 & 7), TRUE, 0, R13);	// mov r13, softTLB
+    x.Quad((long) softTLB);
+    x.Opcode(0xb8 + (R14 & 7), TRUE, 0, R14);	// mov r14, mainMemory
+    x.Quad((long) mainMemory);
+
+    pcsStored[0] = TRUE;
+    for (i = 0; i < block->length; i++) {
+	BlockOp *op = &block->ops[i];
+	bool delaySlot = (i > 0 && block->ops[i - 1].IsBranch());
+
+	EmitOp(&x, op, i);
+
+	// the delayed load, as in DelayedLoad
+	if (pending == PendingUnknown) {
+	    x.Load(RCX, LoadReg);
+	    x.Load(RDX, LoadValueReg);
+	    x.Byte(0x89); x.Byte(0x14); x.Byte(0x8b);	// [rbx+rcx*4] = edx
+	} else if (pending != NoPending) {
+	    x.Load(RDX, LoadValueReg);
+	    x.Store(pending, RDX);
+	}
+	if (IsLoad(op)) {
+	    x.Set(LoadReg, op->rt);
+	    x.Store(LoadValueReg, RAX);
+	} else if (pending != NoPending) {
+	    x.Set(LoadReg, 0);
+	    x.Set(LoadValueReg, 0);
+	}
+	if (pending == PendingUnknown || pending == 0 || WritesZero(op)) {
+	    x.Set(0, 0);
+	}
+	pending = IsLoad(op) ? op->rt : NoPending;
+
+	// the PCs: only the branch, and its delay slot, need them now
+	if (op->IsBranch()) {
+	    x.Set(PrevPCReg, op->pc);
+	    x.Set(PCReg, op->pc + 4);
+	    x.Store(NextPCReg, RSI);
+	} else if (delaySlot) {
+	    x.Set(PrevPCReg, op->pc);
+	    x.Load(RAX, NextPCReg);
+	    x.Store(PCReg, RAX);
+	    x.AluImm(0, RAX, 4);
+	    x.Store(NextPCReg, RAX);
+	}
+	pcsStored[i + 1] = op->IsBranch() || delaySlot;
+    }
+    if (!pcsStored[block->length]) {
+	EmitPCs(&x, block->ops[block->length - 1].pc);
+    }
+    x.MovImm(RAX, block->length);
+
+    epilogue = x.Size();
+    x.Byte(0x41); x.Byte(0x5e);			// pop r14
+    x.Byte(0x41); x.Byte(0x5d);			// pop r13
+    x.Byte(0x41); x.Byte(0x5c);			// pop r12
+    x.Byte(0x5b);				// pop rbx
+    x.Byte(0xc3);				// ret
+
+    // Where the code stops early: set the PCs as they were before the
+    // instruction, and return how many were done.
+    for (i = 0; i < block->length; i++) {
+	bool used = FALSE;
+
+	for (int j = 0; j < x.numExits; j++) {
+	    if (x.exitBefore[j] == i) {
+		x.Patch(x.exitAt[j]);
+		used = TRUE;
+	    }
+	}
+	if (used) {
+	    if (!pcsStored[i]) {
+		EmitPCs(&x, block->ops[i].pc - 4);
+	    }
+	    x.MovImm(RAX, i);
+	    x.Byte(0xe9);			// jmp epilogue
+	    x.Word(epilogue - (x.Size() + 4));
+	}
+    }
+
+    block->ticks = 0;
+    for (i = 0; i < block->length; i++) {
+	block->ticks += UserTick + opExtraTicks[(int) block->ops[i].opCode];
+    }
+
+    ASSERT(x.Size() <= MaxNativeBlockSize);
+    DEBUG(dbgMach, "Compiled block at PC " << block->pc << ": "
+	  << block->length << " instructions, " << x.Size() << " bytes");
+    nativeUsed += x.Size();
+    return (NativeBlock) x.start;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunNativeBlock
+// 	Run a block's host code, starting at the current PC, if the whole
+//	block can run before the next pending interrupt, and return how
+//	many instructions it ran.  Set "ticks" to how long they took,
+//	according to the cost model.
+//
+//	In self-check mode ("nachos -tc"), afterwards rerun them as
+//	operations, each checked against the interpreter (CheckBlockOp),
+//	and make sure the registers and memory end up the same.
+//
+//	"physAddr" -- where the block starts, in mainMemory
+//	"budget" -- ticks until the next pending interrupt
+//----------------------------------------------------------------------
+
+int
+Machine::RunNativeBlock(TranslatedBlock *block, int physAddr, int budget,
+			int *ticks)
+{
+    int branch = block->length - 1;	// which instruction is the branch,
+					// if any: the last or the one before
+    int done, i, pcAfter;
+    int before[NumTotalRegs], after[NumTotalRegs];
+    char *memoryBefore = NULL, *memoryAfter = NULL;
+
+    *ticks = 0;
+    // the operations stop short of the horizon; the host code can't
+    if (block->ticks + takenBranchTicks > budget) {
+	return 0;
+    }
+    if (!block->ops[branch].IsBranch()) {
+	branch--;
+	if (branch < 0 || !block->ops[branch].IsBranch()) {
+	    branch = -1;
+	}
+    }
+
+    if (checkBlocks) {
+	bcopy(registers, before, sizeof(registers));
+	memoryBefore = new char[MemorySize];
+	bcopy(mainMemory, memoryBefore, MemorySize);
+    }
+    done = (*block->native)(registers);
+
+    if (done == block->length) {
+	*ticks = block->ticks;
+    } else {
+	for (i = 0; i < done; i++) {
+	    *ticks += UserTick + opExtraTicks[(int) block->ops[i].opCode];
+	}
+    }
+    if (branch >= 0 && branch < done) {
+	pcAfter = (done == branch + 1) ? registers[NextPCReg]
+				       : registers[PCReg];
+	if (pcAfter != block->ops[branch].pc + 8) {
+	    *ticks += takenBranchTicks;
+	}
+    }
+    if (profileCounts != NULL && !checkBlocks) {  // else counted by
+	for (i = 0; i < done; i++) {		   // CheckBlockOp
+	    profileCounts[(physAddr >> 2) + i]++;
+	}
+    }
+
+    if (checkBlocks) {
+	bool agree = TRUE;
+
+	bcopy(registers, after, sizeof(registers));
+	memoryAfter = new char[MemorySize];
+	bcopy(mainMemory, memoryAfter, MemorySize);
+	bcopy(before, registers, sizeof(registers));
+	bcopy(memoryBefore, mainMemory, MemorySize);
+	for (i = 0; i < done; i++) {
+	    bcopy(registers, before, sizeof(registers));
+	    ASSERT(RunBlockOp(&block->ops[i]));
+	    CheckBlockOp(&block->ops[i], before);
+	}
+	for (i = 0; i < NumTotalRegs; i++) {
+	    if (registers[i] != after[i]) {
+		cerr << "Host code for block at PC " << block->pc;
+		cerr << " left register " << i << " = " << after[i];
+		cerr << ", operations: " << registers[i] << "\n";
+		agree = FALSE;
+	    }
+	}
+	for (i = 0; i < MemorySize; i++) {
+	    if (mainMemory[i] != memoryAfter[i]) {
+		cerr << "Host code for block at PC " << block->pc;
+		cerr << " left memory " << i << " = " << (int) memoryAfter[i];
+		cerr << ", operations: " << (int) mainMemory[i] << "\n";
+		agree = FALSE;
+	    }
+	}
+	ASSERT(agree);
+	delete [] memoryBefore;
+	delete [] memoryAfter;
+    }
+    return done;
+}
+
+#endif // TRANSLATE_BLOCKS && x86_64
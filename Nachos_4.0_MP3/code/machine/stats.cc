@@ -19,27 +19,122 @@
 Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
+    numUserInstructions = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numTLBHits = numTLBMisses = numTLBRefills = 0;
+    numICacheHits = numICacheMisses = numDCacheHits = numDCacheMisses = 0;
+    numDeadlinesMet = numDeadlinesMissed = 0;
+    numCPUs = 1;
+    currentCPU = 0;
+    for (int i = 0; i < MaxCPUs; i++) {
+	cpuTicks[i] = cpuIdleTicks[i] = cpuSteals[i] = 0;
+    }
+    parallelRounds = parallelInstructions = 0;
+    hostStartTime = HostCPUTime();
+}
+
+//----------------------------------------------------------------------
+// Statistics::Elapsed
+// 	Return how much simulated time has gone by.  On a multiprocessor,
+//	each CPU has a time of its own; the one furthest ahead is how far
+//	the machine as a whole has got.
+//----------------------------------------------------------------------
+
+int
+Statistics::Elapsed()
+{
+    int elapsed = totalTicks;
+
+    for (int i = 0; i < numCPUs; i++) {
+	if (i != currentCPU && cpuTicks[i] > elapsed) {
+	    elapsed = cpuTicks[i];
+	}
+    }
+    return elapsed;
 }
 
 //----------------------------------------------------------------------
 // Statistics::Print
 // 	Print performance metrics, when we've finished everything
 //	at system shutdown.
+//
+//	On a multiprocessor, also print how busy each CPU was.  A CPU
+//	that is behind the others was idle since -- or, by less than a
+//	time slice, hasn't been simulated yet.  The system and user ticks
+//	are added up over all the CPUs.  With -parallel, also print how
+//	much of the user code ran on the CPUs' host threads.
 //----------------------------------------------------------------------
 
 void
 Statistics::Print()
 {
-    cout << "Ticks: total " << totalTicks << ", idle " << idleTicks;
+    int elapsed = Elapsed();
+
+    cout << "Ticks: total " << elapsed << ", idle " << idleTicks;
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
+    if (numCPUs > 1) {		// only on a multiprocessor
+	for (int i = 0; i < numCPUs; i++) {
+	    int ticks = (i == currentCPU) ? totalTicks : cpuTicks[i];
+	    int idle = cpuIdleTicks[i] + (elapsed - ticks);
+
+	    cout << "CPU " << i << ": busy " << elapsed - idle;
+	    cout << ", idle " << idle;
+	    if (elapsed > 0) {
+		cout << ", utilization " 
+		     << (int) (100.0 * (elapsed - idle) / elapsed) << "%";
+	    }
+	    cout << ", threads stolen " << cpuSteals[i] << "\n";
+	}
+	if (parallelRounds > 0) {	// only with -parallel
+	    cout << "Parallel: rounds " << parallelRounds;
+	    cout << ", user instructions " << parallelInstructions << "\n";
+	}
+    }
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
     cout << "Paging: faults " << numPageFaults << "\n";
+#ifdef USE_TLB
+    cout << "TLB: hits " << numTLBHits << ", misses " << numTLBMisses;
+    cout << ", refills " << numTLBRefills << "\n";
+#endif
+    if (numICacheHits + numICacheMisses > 0) {	// only if simulated
+	cout << "I-cache: hits " << numICacheHits;
+	cout << ", misses " << numICacheMisses << "\n";
+    }
+    if (numDCacheHits + numDCacheMisses > 0) {
+	cout << "D-cache: hits " << numDCacheHits;
+	cout << ", misses " << numDCacheMisses << "\n";
+    }
+    if (numDeadlinesMet + numDeadlinesMissed > 0) {	// only if EDF was used
+	cout << "Deadlines: met " << numDeadlinesMet;
+	cout << ", missed " << numDeadlinesMissed << "\n";
+    }
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
 }
+
+//----------------------------------------------------------------------
+// Statistics::PrintHostTime
+// 	Print how much host CPU time the simulation has taken so far, 
+//	and what that works out to per user instruction.  This is a
+//	measure of the simulator, not of the simulated system: compare
+//	it across builds (e.g., with and without THREADED_DISPATCH).
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintHostTime()
+{
+    double elapsed = HostCPUTime() - hostStartTime;
+
+    cout << "Host time: " << elapsed << " seconds, " << numUserInstructions;
+    cout << " user instructions";
+    if (numUserInstructions > 0) {
+	cout << ", " << (elapsed * 1e9) / numUserInstructions;
+	cout << " ns per instruction";
+    }
+    cout << endl;
+}
@@ -13,6 +13,8 @@
 
 #include "copyright.h"
 
+const int MaxCPUs = 8;		// most CPUs the machine can have
+
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
 // many user instructions executed, etc.
@@ -26,7 +28,10 @@ class Statistics {
     int systemTicks;	 	// Time spent executing system code
     int userTicks;       	// Time spent executing user code
 				// (this is also equal to # of
-				// user instructions executed)
+				// user instructions executed, unless
+				// some are set to take longer -- see
+				// Machine::SetInstructionCosts)
+    int numUserInstructions;	// number of user instructions executed
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
@@ -35,10 +40,35 @@ class Statistics {
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numTLBHits;		// number of translations found in the TLB
+    int numTLBMisses;		// number of translations not in the TLB
+    int numTLBRefills;		// number of entries loaded into the TLB
+    int numICacheHits;		// number of instruction fetches that hit
+    int numICacheMisses;	// and missed in the instruction cache
+    int numDCacheHits;		// number of loads and stores that hit
+    int numDCacheMisses;	// and missed in the data cache
+    int numDeadlinesMet;	// number of real-time jobs that finished
+    int numDeadlinesMissed;	// by their deadlines, and that didn't
+
+    int numCPUs;		// CPUs being simulated (see -ncpu)
+    int currentCPU;		// the one being simulated now, whose
+				// time is totalTicks
+    int cpuTicks[MaxCPUs];	// time on each of the others, when
+				// it was last simulated
+    int cpuIdleTicks[MaxCPUs];	// time each CPU spent idle
+    int cpuSteals[MaxCPUs];	// threads each CPU took from another
+				// CPU's ready list
+    int parallelRounds;		// times the CPUs ran ahead at once, on
+				// host threads (see -parallel)
+    int parallelInstructions;	// user instructions they ran that way
+
+    double hostStartTime;	// host CPU time (seconds) when Nachos started
 
     Statistics(); 		// initialize everything to zero
 
+    int Elapsed();		// time on the CPU furthest ahead
     void Print();		// print collected statistics
+    void PrintHostTime();	// print host time per user instruction
 };
 
 // Constants used to reflect the relative time an operation would
@@ -40,9 +40,26 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
     randomize = doRandom;
     callPeriodically = toCall;
     disable = FALSE;
+    armed = FALSE;
     SetInterrupt();
 }
 
+//----------------------------------------------------------------------
+// Timer::Enable
+//      Turn the timer device back on after Disable.  If its last 
+//	interrupt has already occurred, start generating them again,
+//	from now.
+//----------------------------------------------------------------------
+
+void
+Timer::Enable()
+{
+    disable = FALSE;
+    if (!armed) {
+	SetInterrupt();
+    }
+}
+
 //----------------------------------------------------------------------
 // Timer::CallBack
 //      Routine called when interrupt is generated by the hardware 
@@ -52,6 +69,8 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
 void 
 Timer::CallBack() 
 {
+    armed = FALSE;
+
     // invoke the Nachos interrupt handler for this device
     callPeriodically->CallBack();
     
@@ -77,5 +96,6 @@ Timer::SetInterrupt()
         }
        // schedule the next timer device interrupt
        kernel->interrupt->Schedule(this, delay, TimerInt);
+       armed = TRUE;
     }
 }
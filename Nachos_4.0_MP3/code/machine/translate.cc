@@ -21,7 +21,10 @@
 //	anything at all about that.
 //
 //	Note that the contents of the TLB are specific to an address space.
-//	If the address space changes, so does the contents of the TLB!
+//	Each entry is tagged with the identifier (ASID) of its address
+//	space, and only matches while that address space is running
+//	(Machine::currentASID), so the kernel need not flush the TLB
+//	when the address space changes.
 //
 // DO NOT CHANGE -- part of the machine emulation
 //
@@ -77,6 +80,11 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 //   	Returns FALSE if the translation step from virtual to physical memory
 //   	failed.
 //
+//	Only the user program's own loads go through the data cache.
+//	The kernel (say, copying a system call's arguments) runs in
+//	SystemMode, and its reads would otherwise be charged to the 
+//	user instruction that trapped.
+//
 //	"addr" -- the virtual address to read from
 //	"size" -- the number of bytes to read (1, 2, or 4)
 //	"value" -- the place to write the result
@@ -88,27 +96,34 @@ Machine::ReadMem(int addr, int size, int *value)
     int data;
     ExceptionType exception;
     int physicalAddress;
+    char *hostAddress;
     
     DEBUG(dbgAddr, "Reading VA " << addr << ", size " << size);
     
-    exception = Translate(addr, &physicalAddress, size, FALSE);
-    if (exception != NoException) {
-	RaiseException(exception, addr);
-	return FALSE;
+    hostAddress = SoftTranslate(addr, size, FALSE);
+    if (hostAddress == NULL) {
+	exception = Translate(addr, &physicalAddress, size, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	hostAddress = &mainMemory[physicalAddress];
     }
+    if (dcache != NULL && kernel->interrupt->getStatus() == UserMode)
+	extraTicks += dcache->Access(hostAddress - mainMemory);
     switch (size) {
       case 1:
-	data = mainMemory[physicalAddress];
+	data = *hostAddress;
 	*value = data;
 	break;
 	
       case 2:
-	data = *(unsigned short *) &mainMemory[physicalAddress];
+	data = *(unsigned short *) hostAddress;
 	*value = ShortToHost(data);
 	break;
 	
       case 4:
-	data = *(unsigned int *) &mainMemory[physicalAddress];
+	data = *(unsigned int *) hostAddress;
 	*value = WordToHost(data);
 	break;
 
@@ -127,6 +142,9 @@ Machine::ReadMem(int addr, int size, int *value)
 //   	Returns FALSE if the translation step from virtual to physical memory
 //   	failed.
 //
+//	As with ReadMem, only the user program's stores go through the
+//	data cache.
+//
 //	"addr" -- the virtual address to write to
 //	"size" -- the number of bytes to be written (1, 2, or 4)
 //	"value" -- the data to be written
@@ -137,35 +155,75 @@ Machine::WriteMem(int addr, int size, int value)
 {
     ExceptionType exception;
     int physicalAddress;
+    char *hostAddress;
      
     DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
 
-    exception = Translate(addr, &physicalAddress, size, TRUE);
-    if (exception != NoException) {
-	RaiseException(exception, addr);
-	return FALSE;
+    hostAddress = SoftTranslate(addr, size, TRUE);
+    if (hostAddress == NULL) {
+	exception = Translate(addr, &physicalAddress, size, TRUE);
+	if (exception != NoException) {
+	    RaiseException(exception, addr);
+	    return FALSE;
+	}
+	hostAddress = &mainMemory[physicalAddress];
     }
+    if (dcache != NULL && kernel->interrupt->getStatus() == UserMode)
+	extraTicks += dcache->Access(hostAddress - mainMemory);
     switch (size) {
       case 1:
-	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
+	*hostAddress = (unsigned char) (value & 0xff);
 	break;
 
       case 2:
-	*(unsigned short *) &mainMemory[physicalAddress]
+	*(unsigned short *) hostAddress
 		= ShortToMachine((unsigned short) (value & 0xffff));
 	break;
       
       case 4:
-	*(unsigned int *) &mainMemory[physicalAddress]
+	*(unsigned int *) hostAddress
 		= WordToMachine((unsigned int) value);
 	break;
 	
       default: ASSERT(FALSE);
     }
+    physicalAddress = hostAddress - mainMemory;
+    if (decodeCache[physicalAddress >> 2].decoded)	// overwrote code
+	InvalidateCode(physicalAddress, size);
     
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::InvalidateCode
+//      Forget any predecoded instructions in the physical memory range
+//	[physAddr, physAddr + size).  Must be called by the kernel whenever
+//	it writes mainMemory directly, instead of through WriteMem (for
+//	example, when loading a program, or copying in the result of a 
+//	Read system call).
+//
+//	"physAddr" -- the first physical address written
+//	"size" -- the number of bytes written
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateCode(int physAddr, int size)
+{
+    int first = physAddr >> 2;
+    int last = (physAddr + size - 1) >> 2;
+
+    if (size <= 0)
+	return;
+    ASSERT(physAddr >= 0 && physAddr + size <= MemorySize);
+    for (int i = first; i <= last; i++) {
+#ifdef TRANSLATE_BLOCKS
+	if (decodeCache[i].decoded)	// blocks may include this word
+	    blocksStale = TRUE;
+#endif
+	decodeCache[i].decoded = FALSE;
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -214,18 +272,25 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	    return PageFaultException;
 	}
 	entry = &pageTable[vpn];
-    } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))) {
+    } else {					// only search vpn's set
+	int first = (vpn % (tlbSize / tlbWays)) * tlbWays;
+
+        for (entry = NULL, i = first; i < first + tlbWays; i++)
+    	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))
+		    && tlb[i].asid == currentASID) {
 		entry = &tlb[i];			// FOUND!
 		break;
 	    }
 	if (entry == NULL) {				// not found
     	    DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
+	    stats->numTLBMisses++;
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	stats->numTLBHits++;
+	if (tlbPolicy == TLBLRU)
+	    tlbStamp[i] = ++tlbClock;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -246,5 +311,109 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG(dbgAddr, "phys addr = " << *physAddr);
+
+    // remember the translation, so we can skip all of the above
+    // the next time the page is used
+    if (useSoftTLB) {
+	SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+
+	cached->virtualPage = vpn;
+	cached->page = &mainMemory[pageFrame * PageSize];
+	cached->writable = writing;	// a read leaves the dirty bit to 
+					// be set by the first write
+    }
     return NoException;
 }
+
+//----------------------------------------------------------------------
+// Machine::SoftTranslate
+// 	Look for a virtual address in the soft TLB, the simulator's cache
+//	of translations that Translate has already done.  If found, return
+//	a pointer to where the address lives in mainMemory; otherwise
+//	return NULL, and the caller must use Translate.
+//
+//	The use bit of a cached page is already set, and so is its dirty
+//	bit if the entry is writable, so a hit has no side effects on the
+//	page table or TLB.  Misaligned accesses always miss, so that
+//	Translate raises the exception.
+//
+//	"virtAddr" -- the virtual address to translate
+//	"size" -- the amount of memory being read or written
+// 	"writing" -- if TRUE, only hit if the page can be written
+//----------------------------------------------------------------------
+
+char *
+Machine::SoftTranslate(int virtAddr, int size, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    SoftTLBEntry *cached = &softTLB[vpn % SoftTLBSize];
+
+    if (cached->virtualPage != vpn || (writing && !cached->writable)
+	    || (virtAddr & (size - 1))) {
+	return NULL;
+    }
+    return cached->page + ((unsigned) virtAddr % PageSize);
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushSoftTLB
+// 	Forget all of the translations cached by SoftTranslate.  Must be
+//	called whenever the mapping Translate would find changes: when
+//	the page table is switched (AddrSpace::RestoreState), or when the
+//	kernel modifies an entry of the page table or TLB, including 
+//	clearing its use or dirty bit.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushSoftTLB()
+{
+    for (int i = 0; i < SoftTLBSize; i++) {
+	softTLB[i].virtualPage = (unsigned) -1;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::RefillTLB
+// 	Load a translation into the TLB, typically after a TLB miss.
+//	The entry goes in the set for its virtual page: in place of
+//	an entry for the same page, if there is one, otherwise in an
+//	empty slot, otherwise in place of the entry chosen by the
+//	replacement policy.  The entry replaced is simply discarded; the
+//	kernel must save its use and dirty bits first if it wants them.
+//
+//	"entry" -- the translation to copy into the TLB
+//----------------------------------------------------------------------
+
+void
+Machine::RefillTLB(TranslationEntry *entry)
+{
+    int first = (entry->virtualPage % (tlbSize / tlbWays)) * tlbWays;
+    int victim = -1;
+    int i;
+
+    ASSERT(tlb != NULL);
+    for (i = first; i < first + tlbWays; i++) {
+	if (tlb[i].valid && tlb[i].virtualPage == entry->virtualPage
+		&& tlb[i].asid == entry->asid) {
+	    victim = i;				// replace the old copy
+	    break;
+	}
+	if (!tlb[i].valid && victim == -1)
+	    victim = i;
+    }
+    if (victim == -1) {				// set is full
+	if (tlbPolicy == TLBRandom) {
+	    victim = first + RandomNumber() % tlbWays;
+	} else {				// oldest load (FIFO) or use (LRU)
+	    victim = first;
+	    for (i = first + 1; i < first + tlbWays; i++)
+		if (tlbStamp[i] < tlbStamp[victim])
+		    victim = i;
+	}
+    }
+    DEBUG(dbgAddr, "TLB refill: page " << entry->virtualPage << " in entry " 
+	  << victim);
+    tlb[victim] = *entry;
+    tlbStamp[victim] = ++tlbClock;
+    stats->numTLBRefills++;
+}
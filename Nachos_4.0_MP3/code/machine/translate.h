@@ -40,6 +40,25 @@ class TranslationEntry {
 			// page is referenced or modified.
     bool dirty;         // This bit is set by the hardware every time the
 			// page is modified.
+    int asid;		// The address space the page belongs to.  A TLB
+			// entry only matches when this is the machine's
+			// currentASID, so entries of several address
+			// spaces can be in the TLB at once.
+};
+
+// The following class defines an entry in the simulator's own cache of
+// recent translations (the "soft TLB").  Unlike the TLB above, it is
+// invisible to the Nachos kernel: it just lets the simulator skip the
+// full table lookup when a page it has already translated is used
+// again, by remembering where that page lives in the host's memory.
+
+class SoftTLBEntry {
+  public:
+    unsigned int virtualPage;	// The virtual page # cached, or -1 if none
+    char *page;			// Start of the physical page, in the
+				// host's copy of "mainMemory"
+    bool writable;		// If FALSE, writes must take the slow path
+				// (so Translate can set the dirty bit)
 };
 
 #endif
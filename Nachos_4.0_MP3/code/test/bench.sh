@@ -0,0 +1,53 @@
+#!/bin/bash
+# bench.sh -- compare the host speed of the MIPS simulator's two
+# dispatch engines (the default switch, and -DTHREADED_DISPATCH).
+#
+# For each engine, builds nachos with ../build.linux's Makefile, in a
+# scratch directory next to it that is removed afterwards -- so the
+# nachos in ../build.linux, and how it was built, are left alone.
+# Then runs each program with "-d p" and reports the host time per
+# user instruction, printed when the program exits.  Build the
+# programs first, e.g.
+#	make matmult sort
+#
+# usage: ./bench.sh [program ...]		(default: matmult sort)
+
+BUILD=../build.linux
+DEFS="-DFILESYS_STUB -DRDATA -DSIM_FIX"
+PROGS=${*:-"matmult sort"}
+
+SCRATCH=$(mktemp -d $BUILD/../build.bench.XXXXXX) || exit 1
+trap 'rm -rf $SCRATCH' EXIT
+
+cp $BUILD/Makefile $BUILD/Makefile.dep $SCRATCH
+
+for engine in switch threaded; do
+    if [ $engine = threaded ]; then
+	defines="$DEFS -DTHREADED_DISPATCH"
+    else
+	defines="$DEFS"
+    fi
+    (cd $SCRATCH && make clean > /dev/null &&
+	make DEFINES="$defines" > /dev/null 2>&1) || {
+	echo "bench.sh: can't build nachos with $defines" >&2
+	exit 1
+    }
+
+    for prog in $PROGS; do
+	if [ ! -f $prog ]; then
+	    echo "$engine $prog: not built (make $prog)"
+	    continue
+	fi
+	out=$(mktemp)
+	# nachos keeps running after the last user program exits,
+	# so stop it once the report has been printed
+	$SCRATCH/nachos -d p -e $prog > $out &
+	pid=$!
+	while kill -0 $pid 2> /dev/null && ! grep -q "Host time" $out; do
+	    sleep 1
+	done
+	kill $pid 2> /dev/null
+	echo "$engine $prog: $(grep 'Host time' $out)"
+	rm -f $out
+    done
+done
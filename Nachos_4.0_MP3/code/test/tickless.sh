@@ -0,0 +1,30 @@
+#!/bin/bash
+# tickless.sh -- check that "-tickless" only turns the timer off when
+# nothing else could run.
+#
+# Runs sort (priority 60) with test_RR1 (priority 0) waiting in L3,
+# with and without -tickless.  sort keeps the CPU at every time slice
+# ("will keep running"), so test_RR1 only gets it by aging, which
+# needs the timer; it must age at the same tick either way.  Build the
+# programs first, e.g.
+#	make sort test_RR1
+#
+# usage: ./tickless.sh [nachos]		(default: ../build.linux/nachos)
+
+NACHOS=${1:-../build.linux/nachos}
+
+# the tick at which test_RR1 (thread 3) first ages
+firstAging() {
+    timeout 120 $NACHOS $* -ep sort 60 -ep test_RR1 0 2> /dev/null |
+	grep -m 1 "Thread 3 changes its priority" | sed 's/ :.*//'
+}
+
+ticking=$(firstAging)
+tickless=$(firstAging -tickless)
+echo "without -tickless: ${ticking:-never}"
+echo "with -tickless:    ${tickless:-never}"
+if [ -z "$ticking" ] || [ "$ticking" != "$tickless" ]; then
+    echo "tickless.sh: FAILED"
+    exit 1
+fi
+echo "tickless.sh: ok"
@@ -11,6 +11,7 @@
 #include "copyright.h"
 #include "alarm.h"
 #include "main.h"
+#include "schedstats.h"
 
 //----------------------------------------------------------------------
 // Alarm::Alarm
@@ -18,13 +19,38 @@
 //
 //      "doRandom" -- if true, arrange for the hardware interrupts to 
 //		occur at random, instead of fixed, intervals.
+//      "tickless" -- if true, turn the timer off while at most one 
+//		thread is runnable (see Alarm::CallBack).
 //----------------------------------------------------------------------
 
-Alarm::Alarm(bool doRandom)
+Alarm::Alarm(bool doRandom, bool tickless)
 {
+    stopWhenAlone = tickless;
     timer = new Timer(doRandom, this);
 }
 
+//----------------------------------------------------------------------
+// NumRunnable
+//	Return how many threads could use the CPU: the ones on the
+//	ready list, plus the current thread, if it is running (rather
+//	than blocked, with the machine idle, or about to go on the
+//	ready list itself).  On a multiprocessor, add the threads running
+//	on the other CPUs.
+//----------------------------------------------------------------------
+
+static int
+NumRunnable()
+{
+    int num = kernel->scheduler->NumReady() 
+		+ kernel->scheduler->NumRunningElsewhere();
+
+    if (kernel->interrupt->getStatus() != IdleMode 
+		&& kernel->currentThread->getStatus() == RUNNING) {
+	num++;
+    }
+    return num;
+}
+
 //----------------------------------------------------------------------
 // Alarm::CallBack
 //	Software interrupt handler for the timer device. The timer device is
@@ -39,8 +65,18 @@ Alarm::Alarm(bool doRandom)
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
+//	With -schedstats, sample the length of the ready queues.
+//
 //	For now, just provide time-slicing.  Only need to time slice 
-//      if we're currently running something (in other words, not idle).
+//      if we're currently running something (in other words, not idle),
+//	and the scheduling policy says its time slice is up.  On a 
+//	multiprocessor, even if it isn't, another CPU gets its turn to
+//	be simulated.
+//
+//	In tickless mode, if there's no other thread to switch to, a 
+//	time slice would only put the current thread back on the CPU;
+//	so instead, turn the timer off until Alarm::ThreadReady finds
+//	a competitor.
 //----------------------------------------------------------------------
 
 void 
@@ -49,10 +85,38 @@ Alarm::CallBack()
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
     
+    if (kernel->schedStats != NULL) {
+	kernel->schedStats->Sample();
+    }
+    if (stopWhenAlone && NumRunnable() <= 1) {
+	DEBUG(dbgInt, "Only one thread runnable, timer off");
+	timer->Disable();
+	return;
+    }
     if (status != IdleMode) {
-	interrupt->YieldOnReturn();
+	if (kernel->scheduler->TimeSliceOver()) {
+	    interrupt->YieldOnReturn();
+	} else if (kernel->scheduler->NumCPUs() > 1) {
+	    kernel->scheduler->EndTurn();
+	    interrupt->YieldOnReturn();
+	}
+    }
+}
+//----------------------------------------------------------------------
+// Alarm::ThreadReady
+//	Called by the scheduler whenever it puts a thread on the ready
+//	list.  In tickless mode, if the timer was turned off and there 
+//	is now more than one runnable thread, turn it back on.
+//----------------------------------------------------------------------
+
+void
+Alarm::ThreadReady()
+{
+    if (stopWhenAlone && NumRunnable() > 1) {
+	timer->Enable();
     }
 }
+
 /*
 void
 Alarm::WaitUntil(int x){
@@ -25,15 +25,21 @@
 // The following class defines a software alarm clock. 
 class Alarm : public CallBackObj {
   public:
-    Alarm(bool doRandomYield);	// Initialize the timer, and callback 
+    Alarm(bool doRandomYield, bool tickless);
+				// Initialize the timer, and callback 
 				// to "toCall" every time slice.
     ~Alarm() { delete timer; }
     
     void WaitUntil(int x);	// suspend execution until time > now + x
                                 // this method is not yet implemented
 
+    void ThreadReady();		// a thread has been put on the ready
+				// list; time slicing may be needed again
+
   private:
     Timer *timer;		// the hardware timer device
+    bool stopWhenAlone;		// turn the timer off while there is
+				// nothing to time slice
 
     void CallBack();		// called when the hardware
 				// timer generates an interrupt
@@ -15,6 +15,7 @@
 #include "libtest.h"
 #include "string.h"
 #include "synchdisk.h"
+#include "schedstats.h"
 #include "post.h"
 #include "synchconsole.h"
 
@@ -27,8 +28,26 @@
 Kernel::Kernel(int argc, char **argv)
 {
     randomSlice = FALSE; 
+    ticklessTimer = FALSE;
+    schedPolicy = SchedMultiLevel;
+    schedQuantum = TimerTicks;
+    numCPUs = 1;
+    parallelTicks = 0;
+    schedStatsPrefix = NULL;
+    schedStats = NULL;
+    stackPoolSize = 16;
+    stackPool = NULL;
     debugUserProg = FALSE;
+    checkTranslation = FALSE;
+    tlbEntries = TLBSize;       // default TLB is fully associative, 
+    tlbWays = TLBSize;          // with random replacement
+    tlbPolicy = TLBRandom;
+    multiplyTicks = divideTicks = memoryTicks = UserTick;
+    branchTicks = 0;            // every instruction takes UserTick
+    icacheConfig[0] = dcacheConfig[0] = 0;      // no caches
+    profileUserProg = FALSE;
     consoleIn = NULL;          // default is stdin
+    consoleInWait = FALSE;
     consoleOut = NULL;         // default is stdout
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
@@ -43,8 +62,100 @@ Kernel::Kernel(int argc, char **argv)
 			// number generator
 	    	randomSlice = TRUE;
 	    	i++;
+        } else if (strcmp(argv[i], "-tickless") == 0) {
+            ticklessTimer = TRUE;
+        } else if (strcmp(argv[i], "-sched") == 0) {
+            ASSERT(i + 1 < argc);
+            if (strcmp(argv[i + 1], "mlq") == 0) {
+                schedPolicy = SchedMultiLevel;
+            } else if (strcmp(argv[i + 1], "fifo") == 0) {
+                schedPolicy = SchedFIFO;
+            } else if (strcmp(argv[i + 1], "rr") == 0) {
+                schedPolicy = SchedRR;
+            } else if (strcmp(argv[i + 1], "mlfq") == 0) {
+                schedPolicy = SchedMLFQ;
+            } else if (strcmp(argv[i + 1], "sjf") == 0) {
+                schedPolicy = SchedSJF;
+            } else if (strcmp(argv[i + 1], "lottery") == 0) {
+                schedPolicy = SchedLottery;
+            } else if (strcmp(argv[i + 1], "stride") == 0) {
+                schedPolicy = SchedStride;
+            } else if (strcmp(argv[i + 1], "cfs") == 0) {
+                schedPolicy = SchedCFS;
+            } else if (strcmp(argv[i + 1], "edf") == 0) {
+                schedPolicy = SchedEDF;
+            } else {
+                cout << "Unknown scheduling policy: " << argv[i + 1] << "\n";
+                ASSERT(FALSE);
+            }
+            i++;
+        } else if (strcmp(argv[i], "-quantum") == 0) {
+            ASSERT(i + 1 < argc);
+            schedQuantum = atoi(argv[i + 1]);
+            ASSERT(schedQuantum > 0);
+            i++;
+        } else if (strcmp(argv[i], "-ncpu") == 0) {
+            ASSERT(i + 1 < argc);
+            numCPUs = atoi(argv[i + 1]);
+            ASSERT(numCPUs >= 1 && numCPUs <= MaxCPUs);
+            i++;
+        } else if (strcmp(argv[i], "-parallel") == 0) {
+            ASSERT(i + 1 < argc);
+#if defined(USE_TLB) || defined(TRANSLATE_BLOCKS)
+            cout << "-parallel needs Nachos without USE_TLB and "
+                 << "TRANSLATE_BLOCKS\n";
+            ASSERT(FALSE);
+#endif
+            parallelTicks = atoi(argv[i + 1]);
+            ASSERT(parallelTicks > 0);
+            i++;
+        } else if (strcmp(argv[i], "-schedstats") == 0) {
+            ASSERT(i + 1 < argc);
+            schedStatsPrefix = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "-stackpool") == 0) {
+            ASSERT(i + 1 < argc);
+            stackPoolSize = atoi(argv[i + 1]);
+            ASSERT(stackPoolSize >= 0);
+            i++;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
+        } else if (strcmp(argv[i], "-tc") == 0) {
+            checkTranslation = TRUE;
+        } else if (strcmp(argv[i], "-tlb") == 0) {
+            ASSERT(i + 3 < argc);
+            tlbEntries = atoi(argv[i + 1]);
+            tlbWays = atoi(argv[i + 2]);
+            if (strcmp(argv[i + 3], "random") == 0) {
+                tlbPolicy = TLBRandom;
+            } else if (strcmp(argv[i + 3], "fifo") == 0) {
+                tlbPolicy = TLBFIFO;
+            } else if (strcmp(argv[i + 3], "lru") == 0) {
+                tlbPolicy = TLBLRU;
+            } else {
+                cout << "Unknown TLB replacement policy: " << argv[i + 3];
+                cout << "\n";
+                ASSERT(FALSE);
+            }
+            ASSERT(tlbEntries > 0 && tlbWays > 0 && tlbEntries % tlbWays == 0);
+            i += 3;
+        } else if (strcmp(argv[i], "-cost") == 0) {
+            ASSERT(i + 4 < argc);
+            multiplyTicks = atoi(argv[i + 1]);
+            divideTicks = atoi(argv[i + 2]);
+            memoryTicks = atoi(argv[i + 3]);
+            branchTicks = atoi(argv[i + 4]);
+            i += 4;
+        } else if (strcmp(argv[i], "-prof") == 0) {
+            profileUserProg = TRUE;
+        } else if (strcmp(argv[i], "-icache") == 0 ||
+                   strcmp(argv[i], "-dcache") == 0) {
+            int *config = (argv[i][1] == 'i') ? icacheConfig : dcacheConfig;
+            ASSERT(i + 4 < argc);
+            for (int j = 0; j < 4; j++) {
+                config[j] = atoi(argv[i + 1 + j]);
+            }
+            i += 4;
 		} else if (strcmp(argv[i], "-e") == 0) {
         	execfile[++execfileNum]= argv[++i];
 			priority[execfileNum] = 0;
@@ -57,6 +168,8 @@ Kernel::Kernel(int argc, char **argv)
 	    	ASSERT(i + 1 < argc);
 	    	consoleIn = argv[i + 1];
 	    	i++;
+		} else if (strcmp(argv[i], "-ciwait") == 0) {
+	    	consoleInWait = TRUE;
 		} else if (strcmp(argv[i], "-co") == 0) {
 	    	ASSERT(i + 1 < argc);
 	    	consoleOut = argv[i + 1];
@@ -75,8 +188,22 @@ Kernel::Kernel(int argc, char **argv)
             i++;
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
+	   		cout << "Partial usage: nachos [-tickless]\n";
+	   		cout << "Partial usage: nachos [-sched mlq|fifo|rr|mlfq|sjf|lottery|stride|cfs|edf]\n";
+	   		cout << "Partial usage: nachos [-quantum ticks]\n";
+	   		cout << "Partial usage: nachos [-ncpu number]\n";
+	   		cout << "Partial usage: nachos [-parallel ticks]\n";
+	   		cout << "Partial usage: nachos [-schedstats prefix]\n";
+	   		cout << "Partial usage: nachos [-stackpool number]\n";
 	   		cout << "Partial usage: nachos [-s]\n";
+	   		cout << "Partial usage: nachos [-tc]\n";
+	   		cout << "Partial usage: nachos [-tlb entries ways random|fifo|lru]\n";
+	   		cout << "Partial usage: nachos [-cost mult div mem branch]\n";
+	   		cout << "Partial usage: nachos [-prof]\n";
+	   		cout << "Partial usage: nachos [-icache size line ways penalty]\n";
+	   		cout << "Partial usage: nachos [-dcache size line ways penalty]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
+            cout << "Partial usage: nachos [-ciwait]\n";
 #ifndef FILESYS_STUB
 	    	cout << "Partial usage: nachos [-nf]\n";
 #endif
@@ -95,6 +222,9 @@ Kernel::Kernel(int argc, char **argv)
 void
 Kernel::Initialize()
 {
+    stackPool = new StackPool(stackPoolSize);
+					// reuse the stacks of finished threads
+
     // We didn't explicitly allocate the current thread we are running in.
     // But if it ever tries to give up the CPU, we better have a Thread
     // object to save its state. 
@@ -108,10 +238,40 @@ Kernel::Initialize()
 
     stats = new Statistics();		// collect statistics
     interrupt = new Interrupt;		// start up interrupt handling
-    scheduler = new Scheduler();	// initialize the ready queue
-    alarm = new Alarm(randomSlice);	// start up time slicing
-    machine = new Machine(debugUserProg);
-    synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
+    scheduler = new Scheduler(schedPolicy, schedQuantum, numCPUs);
+					// initialize the ready queue
+    if (schedStatsPrefix != NULL) {
+	schedStats = new SchedStats(schedStatsPrefix);
+					// record what the scheduler does
+    }
+    alarm = new Alarm(randomSlice, ticklessTimer);
+    					// start up time slicing
+    machine = new Machine(debugUserProg, checkTranslation, tlbEntries, tlbWays,
+			  tlbPolicy);
+    machine->SetInstructionCosts(multiplyTicks, divideTicks, memoryTicks,
+				 branchTicks);
+    if (profileUserProg) {
+	machine->StartProfiling();
+    }
+    if (icacheConfig[0] > 0) {
+	machine->icache = new Cache(icacheConfig[0], icacheConfig[1],
+			icacheConfig[2], icacheConfig[3],
+			&stats->numICacheHits, &stats->numICacheMisses);
+    }
+    if (dcacheConfig[0] > 0) {
+	machine->dcache = new Cache(dcacheConfig[0], dcacheConfig[1],
+			dcacheConfig[2], dcacheConfig[3],
+			&stats->numDCacheHits, &stats->numDCacheMisses);
+    }
+    if (parallelTicks > 0) {
+	// the host threads' machines have no debugger, profile or caches
+	ASSERT(numCPUs > 1);
+	ASSERT(!debugUserProg && !profileUserProg);
+	ASSERT(icacheConfig[0] == 0 && dcacheConfig[0] == 0);
+	scheduler->RunInParallel(parallelTicks);
+    }
+    synchConsoleIn = new SynchConsoleInput(consoleIn, consoleInWait);
+    					// input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
     synchDisk = new SynchDisk();    //
 #ifdef FILESYS_STUB
@@ -134,6 +294,7 @@ Kernel::Initialize()
 
 Kernel::~Kernel()
 {
+    delete schedStats;			// writes out what it recorded
     delete stats;
     delete interrupt;
     delete scheduler;
@@ -145,6 +306,7 @@ Kernel::~Kernel()
     delete fileSystem;
     delete postOfficeIn;
     delete postOfficeOut;
+    delete stackPool;
     
     Exit(0);
 }
@@ -158,9 +320,15 @@ void
 Kernel::ThreadSelfTest() {
    Semaphore *semaphore;
    SynchList<int> *synchList;
+   EDFPolicy *edfPolicy;
    
    LibSelfTest();		// test library routines
    
+   				// test EDF admission control
+   edfPolicy = new EDFPolicy;
+   edfPolicy->SelfTest();
+   delete edfPolicy;
+   
    currentThread->SelfTest();	// test thread switching
    
    				// test semaphore operation
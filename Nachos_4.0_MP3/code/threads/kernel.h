@@ -18,6 +18,7 @@
 #include "alarm.h"
 #include "filesys.h"
 #include "machine.h"
+#include "stackpool.h"
 
 typedef int OpenFileId;
 
@@ -26,6 +27,7 @@ class PostOfficeOutput;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class SchedStats;
 
 
 
@@ -58,7 +60,10 @@ class Kernel {
 // they're global variables used everywhere.
 
     Thread *currentThread;	// the thread holding the CPU
+    StackPool *stackPool;	// stacks of finished threads, for reuse
     Scheduler *scheduler;	// the ready list
+    SchedStats *schedStats;	// what the scheduler has done, with
+				// -schedstats; NULL otherwise
     Interrupt *interrupt;	// interrupt status
     Statistics *stats;		// performance metrics
     Alarm *alarm;		// the software alarm clock    
@@ -82,9 +87,32 @@ class Kernel {
 	int execfileNum;
 	int threadNum;
     bool randomSlice;		// enable pseudo-random time slicing
+    bool ticklessTimer;		// stop time slicing when only one
+				// thread is runnable
+    SchedPolicyType schedPolicy;// which thread the scheduler runs next
+    int schedQuantum;		// time slice for the RR and MLFQ policies
+    int numCPUs;		// how many CPUs the machine has
+    int parallelTicks;		// how far ahead their user code may run
+				// on host threads; 0 if it doesn't
+    char *schedStatsPrefix;	// where -schedstats writes its CSV files
+    int stackPoolSize;		// most free thread stacks to keep
     bool debugUserProg;         // single step user program
+    bool checkTranslation;      // check translated user code against
+                                // the interpreter
+    int tlbEntries;             // size of the simulated TLB (USE_TLB)
+    int tlbWays;                // TLB entries per set
+    TLBPolicy tlbPolicy;        // which entry a TLB refill replaces
+    int multiplyTicks;          // cost model for user instructions:
+    int divideTicks;            // ticks for a multiply, divide, or
+    int memoryTicks;            // load/store, and extra ticks for
+    int branchTicks;            // a taken branch
+    bool profileUserProg;       // count where user programs spend time
+    int icacheConfig[4];        // size, line size, ways and miss
+    int dcacheConfig[4];        // penalty of the caches (size 0: none)
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
+    bool consoleInWait;         // wait for console input on the host
+                                // when there's nothing else to do
     char *consoleOut;           // file to send console output to
 #ifndef FILESYS_STUB
     bool formatFlag;          // format the disk if this is true
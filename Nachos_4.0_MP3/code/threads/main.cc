@@ -2,25 +2,76 @@
 //	Driver code to initialize, selftest, and run the 
 //	operating system kernel.  
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -tickless
+//              -sched <policy> -quantum <ticks> -ncpu <number>
+//              -parallel <ticks> -schedstats <prefix> -stackpool <number>
+//              -s -tc -tlb <entries> <ways> <policy>
+//              -cost <mult> <div> <mem> <branch>
+//              -icache <size> <line> <ways> <penalty> -dcache <...> -prof
+//              -x <nachos file> -ci <consoleIn> -co <consoleOut> -ciwait
 //              -f -cp <unix file> <nachos file>
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -I <number of devices>
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -tickless stops the timer interrupts that drive time slicing
+//	while no more than one thread is runnable
+//    -sched picks the scheduling policy: mlq (MP3's three ready queues,
+//	the default), fifo, rr (round robin), mlfq (multi-level feedback
+//	queue), sjf (shortest job first), lottery, stride, cfs
+//	(completely fair scheduling) or edf (earliest deadline first,
+//	for threads that have called SetDeadline)
+//    -quantum sets the time slice, in ticks, for rr and mlfq (the
+//	time slice of mlfq's top queue), and cfs's minimum granularity;
+//	TimerTicks by default
+//    -ncpu simulates a multiprocessor with that many CPUs (up to 
+//	MaxCPUs), each with its own ready queue; a CPU with nothing to
+//	run steals a thread from another.  The CPUs are simulated one at
+//	a time, each with its own clock, and how busy each one was is
+//	printed at shutdown
+//    -parallel (with -ncpu) also runs the CPUs' user programs at the
+//	same time, on host threads, up to that many ticks ahead of the
+//	CPU furthest behind; time slices are checked only that often,
+//	so it is cut to the time slice (-quantum) if it is longer
+//    -schedstats records how long each thread waits and runs, and
+//	samples the length of the ready queues, instead of printing
+//	"Tick [...]" lines; the results are written at shutdown to
+//	<prefix>-threads.csv and <prefix>-queues.csv
+//    -stackpool keeps the stacks of up to that many finished threads,
+//	guard pages and all, for new threads to reuse (16 by default; 0
+//	gives every stack back to the host); "-d p" prints how often a
+//	stack was reused
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
+//    -tc checks translated user code against the interpreter
+//	(if Nachos was compiled with TRANSLATE_BLOCKS)
+//    -tlb sets the size and associativity of the TLB, and its
+//	replacement policy: random, fifo or lru (if Nachos was compiled
+//	with USE_TLB)
+//    -cost sets how many ticks user multiplies, divides, and loads and
+//	stores take (1 by default, like every other instruction), and
+//	how many extra ticks a taken branch or jump takes (0 by default)
+//    -icache, -dcache simulate an instruction or data cache, of "size"
+//	bytes, with lines of "line" bytes, "ways" lines per set, and
+//	"penalty" extra ticks for each miss
+//    -prof counts the instructions each user program executes in
+//	each of its functions, and prints them when it exits (function
+//	names come from <program>.sym -- see test/Makefile)
 //    -x runs a user program
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
+//    -ciwait when the machine is idle and waiting only for console
+//	input, give the host time to deliver some between polls, rather
+//	than spinning (needs -tickless, or the timer keeps interrupting)
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -I time how long it takes to simulate the interrupts of the given
+//	number of devices (see Interrupt::SelfTest)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -172,6 +223,7 @@ main(int argc, char **argv)
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    int interruptTestDevices = 0;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;    // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL;  // name of copied file in Nachos
@@ -207,6 +259,11 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-N") == 0) {
 	    networkTestFlag = TRUE;
 	}
+	else if (strcmp(argv[i], "-I") == 0) {
+	    ASSERT(i + 1 < argc);
+	    interruptTestDevices = atoi(argv[i + 1]);
+	    i++;
+	}
 #ifndef FILESYS_STUB
 	else if (strcmp(argv[i], "-cp") == 0) {
 	    ASSERT(i + 2 < argc);
@@ -234,7 +291,7 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
-	    cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+	    cout << "Partial usage: nachos [-K] [-C] [-N] [-I numDevices]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
@@ -264,6 +321,10 @@ main(int argc, char **argv)
     if (networkTestFlag) {
       kernel->NetworkTest();   // two-machine test of the network
     }
+    if (interruptTestDevices > 0) {
+      kernel->interrupt->SelfTest(interruptTestDevices);
+      				// time the interrupt simulation
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL) {
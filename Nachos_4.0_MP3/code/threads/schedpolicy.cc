@@ -0,0 +1,935 @@
+// schedpolicy.cc
+//	Routines for the scheduling policies other than MP3's three
+//	ready queues (which are in scheduler.cc).
+//
+// 	Like the scheduler, these routines assume that interrupts are
+//	already disabled.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "schedpolicy.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// Tickets
+//	Return how many tickets a thread holds, for lottery and stride
+//	scheduling.
+//----------------------------------------------------------------------
+
+static int
+Tickets(Thread *thread)
+{
+    return thread->getPriority() + 1;
+}
+
+//----------------------------------------------------------------------
+// FIFOPolicy::RemoveNext
+// 	Return the thread that has been ready longest, or NULL if there
+//	is none.
+//----------------------------------------------------------------------
+
+Thread *
+FIFOPolicy::RemoveNext()
+{
+    if (readyList->IsEmpty()) {
+	return NULL;
+    }
+    return readyList->RemoveFront();
+}
+
+//----------------------------------------------------------------------
+// RoundRobinPolicy::TimeSliceOver
+// 	Return TRUE if the running thread has had a quantum.  Time slices
+//	are only checked at timer interrupts, so a quantum is rounded up
+//	to the next one.
+//----------------------------------------------------------------------
+
+bool
+RoundRobinPolicy::TimeSliceOver(Thread *thread)
+{
+    return (kernel->stats->totalTicks - thread->getStartTime() >= quantum);
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::MLFQPolicy
+// 	Initialize an empty set of queues.
+//
+//	"q" is the time slice of the top queue, in ticks
+//----------------------------------------------------------------------
+
+MLFQPolicy::MLFQPolicy(int q)
+{
+    for (int i = 0; i < NumMLFQLevels; i++) {
+	queue[i] = new List<Thread *>;
+    }
+    quantum = q;
+    lastBoost = 0;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::~MLFQPolicy
+// 	De-allocate the queues.
+//----------------------------------------------------------------------
+
+MLFQPolicy::~MLFQPolicy()
+{
+    for (int i = 0; i < NumMLFQLevels; i++) {
+	delete queue[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Insert
+// 	Put a thread at the end of its queue.  If it is the running
+//	thread, and it used its whole time slice, move it down a queue
+//	first.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Insert(Thread *thread)
+{
+    int level = thread->schedLevel;
+
+    if (thread == kernel->currentThread && level < NumMLFQLevels - 1
+	    && kernel->stats->totalTicks - thread->getStartTime()
+						>= Quantum(level)) {
+	level++;
+	DEBUG(dbgThread, "MLFQ: " << thread->getName() << " down to " << level);
+    }
+    thread->schedLevel = level;
+    queue[level]->Append(thread);
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::RemoveNext
+// 	Return the first thread in the highest non-empty queue, or NULL
+//	if they are all empty.  Every so often, first move every thread
+//	to the top queue.
+//----------------------------------------------------------------------
+
+Thread *
+MLFQPolicy::RemoveNext()
+{
+    int now = kernel->stats->totalTicks;
+
+    if (now - lastBoost >= MLFQBoostTicks) {
+	DEBUG(dbgThread, "MLFQ: every thread back to the top queue");
+	for (int i = 1; i < NumMLFQLevels; i++) {
+	    while (!queue[i]->IsEmpty()) {
+		Thread *thread = queue[i]->RemoveFront();
+
+		thread->schedLevel = 0;
+		queue[0]->Append(thread);
+	    }
+	}
+	kernel->currentThread->schedLevel = 0;
+	lastBoost = now;
+    }
+    for (int i = 0; i < NumMLFQLevels; i++) {
+	if (!queue[i]->IsEmpty()) {
+	    return queue[i]->RemoveFront();
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::NumReady, Print
+// 	Count and print the threads in all the queues.
+//----------------------------------------------------------------------
+
+int
+MLFQPolicy::NumReady()
+{
+    int num = 0;
+
+    for (int i = 0; i < NumMLFQLevels; i++) {
+	num += queue[i]->NumInList();
+    }
+    return num;
+}
+
+void
+MLFQPolicy::Print()
+{
+    for (int i = 0; i < NumMLFQLevels; i++) {
+	cout << "Queue " << i << ": ";
+	queue[i]->Apply(ThreadPrint);
+	cout << "\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::TimeSliceOver
+// 	Return TRUE if the running thread has used up the time slice of
+//	its queue.
+//----------------------------------------------------------------------
+
+bool
+MLFQPolicy::TimeSliceOver(Thread *thread)
+{
+    return (kernel->stats->totalTicks - thread->getStartTime()
+					>= Quantum(thread->schedLevel));
+}
+
+//----------------------------------------------------------------------
+// ShorterBurst
+// 	Compare two threads by their guessed next CPU burst, and if
+//	those are the same, by ID.
+//----------------------------------------------------------------------
+
+static int
+ShorterBurst(Thread *a, Thread *b)
+{
+    if (a->getBurstTime() != b->getBurstTime()) {
+	return a->getBurstTime() < b->getBurstTime() ? -1 : 1;
+    }
+    if (a->getID() != b->getID()) {
+	return a->getID() < b->getID() ? -1 : 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// SJFPolicy::SJFPolicy
+// 	Initialize an empty ready queue.
+//----------------------------------------------------------------------
+
+SJFPolicy::SJFPolicy()
+{
+    readyList = new SortedList<Thread *>(ShorterBurst);
+}
+
+//----------------------------------------------------------------------
+// SJFPolicy::RemoveNext
+// 	Return the thread with the shortest guessed burst, or NULL if
+//	there is none.
+//----------------------------------------------------------------------
+
+Thread *
+SJFPolicy::RemoveNext()
+{
+    if (readyList->IsEmpty()) {
+	return NULL;
+    }
+    return readyList->RemoveFront();
+}
+
+//----------------------------------------------------------------------
+// SJFPolicy::Blocked
+// 	The running thread's CPU burst is over: average its length into
+//	the guess for the next one.
+//----------------------------------------------------------------------
+
+void
+SJFPolicy::Blocked(Thread *thread)
+{
+    int burst = kernel->stats->totalTicks - thread->getStartTime();
+
+    thread->setBurstTime(0.5 * thread->getBurstTime() + 0.5 * burst);
+    DEBUG(dbgThread, "SJF: " << thread->getName() << " ran " << burst
+		<< ", next burst " << thread->getBurstTime());
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::RemoveNext
+// 	Hold a lottery among the tickets of the ready threads, and
+//	return the winner, or NULL if there are no ready threads.
+//----------------------------------------------------------------------
+
+Thread *
+LotteryPolicy::RemoveNext()
+{
+    ListIterator<Thread *> count(readyList), draw(readyList);
+    Thread *thread;
+    int total = 0, winner;
+
+    if (readyList->IsEmpty()) {
+	return NULL;
+    }
+    for (; !count.IsDone(); count.Next()) {
+	total += Tickets(count.Item());
+    }
+    winner = RandomNumber() % total;
+    for (; ; draw.Next()) {
+	thread = draw.Item();
+	winner -= Tickets(thread);
+	if (winner < 0) {
+	    break;
+	}
+    }
+    readyList->Remove(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// LowerPass
+// 	Compare two threads by their pass, and if those are the same, by
+//	ID.  Passes wrap around, so compare their difference.
+//----------------------------------------------------------------------
+
+static int
+LowerPass(Thread *a, Thread *b)
+{
+    int diff = (int) (a->schedPass - b->schedPass);
+
+    if (diff != 0) {
+	return diff < 0 ? -1 : 1;
+    }
+    if (a->getID() != b->getID()) {
+	return a->getID() < b->getID() ? -1 : 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::StridePolicy
+// 	Initialize an empty ready queue.
+//----------------------------------------------------------------------
+
+StridePolicy::StridePolicy()
+{
+    readyList = new SortedList<Thread *>(LowerPass);
+    globalPass = 0;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::Insert
+// 	Put a thread in the ready queue, by pass.  A thread that is new,
+//	or has been asleep, starts from the pass of the thread that ran
+//	last, so it doesn't get to make up for the time it wasn't ready.
+//----------------------------------------------------------------------
+
+void
+StridePolicy::Insert(Thread *thread)
+{
+    if ((int) (thread->schedPass - globalPass) < 0) {
+	thread->schedPass = globalPass;
+    }
+    readyList->Insert(thread);
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::RemoveNext
+// 	Return the thread with the lowest pass, or NULL if there is none,
+//	and advance its pass by its stride.
+//----------------------------------------------------------------------
+
+Thread *
+StridePolicy::RemoveNext()
+{
+    Thread *thread;
+
+    if (readyList->IsEmpty()) {
+	return NULL;
+    }
+    thread = readyList->RemoveFront();
+    globalPass = thread->schedPass;
+    thread->schedPass += StrideOne / Tickets(thread);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// CFSWeight
+//	Return a thread's CFS weight: how fast its virtual runtime goes
+//	up, compared to a thread of weight CFSNiceZeroWeight.  Priorities
+//	0..149 are spread over UNIX's 40 nice levels, where each level
+//	gets about 1.25 times the CPU of the one below it.
+//----------------------------------------------------------------------
+
+static const int niceToWeight[40] = {
+    /* -20 */ 88761, 71755, 56483, 46273, 36291,
+    /* -15 */ 29154, 23254, 18705, 14949, 11916,
+    /* -10 */  9548,  7620,  6100,  4904,  3906,
+    /*  -5 */  3121,  2501,  1991,  1586,  1277,
+    /*   0 */  1024,   820,   655,   526,   423,
+    /*   5 */   335,   272,   215,   172,   137,
+    /*  10 */   110,    87,    70,    56,    45,
+    /*  15 */    36,    29,    23,    18,    15,
+};
+
+static int
+CFSWeight(Thread *thread)
+{
+    int priority = thread->getPriority();
+
+    if (priority < 0) {
+	priority = 0;
+    } else if (priority > 149) {
+	priority = 149;
+    }
+    return niceToWeight[39 - priority * 40 / 150];
+}
+
+//----------------------------------------------------------------------
+// LowerVruntime
+// 	Compare two threads by their virtual runtime, and if those are
+//	the same, by ID.  Virtual runtimes wrap around, so compare their
+//	difference.
+//----------------------------------------------------------------------
+
+static int
+LowerVruntime(Thread *a, Thread *b)
+{
+    int diff = (int) (a->vruntime - b->vruntime);
+
+    if (diff != 0) {
+	return diff < 0 ? -1 : 1;
+    }
+    if (a->getID() != b->getID()) {
+	return a->getID() < b->getID() ? -1 : 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::CFSPolicy
+// 	Initialize an empty ready tree.
+//
+//	"granularity" is how long a thread runs, in ticks, before another
+//	thread can take the CPU from it
+//----------------------------------------------------------------------
+
+CFSPolicy::CFSPolicy(int granularity)
+{
+    readyTree = new RBTree<Thread *>(LowerVruntime);
+    minGranularity = granularity;
+    minVruntime = 0;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Charge
+// 	Add the ticks "thread" has run since it was last charged to its
+//	virtual runtime, scaled by its weight.  Virtual runtime counts
+//	in 1024ths of a tick, so that it goes up even for the heaviest
+//	threads.
+//
+//	"thread" must not be in the ready tree, unless it has already
+//	been charged this tick.
+//----------------------------------------------------------------------
+
+void
+CFSPolicy::Charge(Thread *thread)
+{
+    int now = kernel->stats->totalTicks;
+    int ticks = now - thread->vruntimeTicks;
+
+    if (ticks > 0) {
+	thread->vruntime += (unsigned int)
+		((double) ticks * CFSNiceZeroWeight * 1024 / CFSWeight(thread));
+	thread->vruntimeTicks = now;
+    }
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Insert
+// 	Put a thread in the ready tree, by virtual runtime.  If it is the
+//	running thread, charge it for its time first.  A thread that is
+//	new, or has been asleep, starts no lower than the thread that ran
+//	last, so it can't make up for the time it wasn't ready by
+//	keeping the CPU to itself.
+//----------------------------------------------------------------------
+
+void
+CFSPolicy::Insert(Thread *thread)
+{
+    if (thread == kernel->currentThread) {
+	Charge(thread);
+    } else if ((int) (thread->vruntime - minVruntime) < 0) {
+	thread->vruntime = minVruntime;
+    }
+    readyTree->Insert(thread);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::RemoveNext
+// 	Return the thread with the lowest virtual runtime, or NULL if
+//	there is none.
+//----------------------------------------------------------------------
+
+Thread *
+CFSPolicy::RemoveNext()
+{
+    Thread *thread;
+
+    if (readyTree->IsEmpty()) {
+	return NULL;
+    }
+    thread = readyTree->RemoveFront();
+    if ((int) (thread->vruntime - minVruntime) > 0) {
+	minVruntime = thread->vruntime;
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::TimeSliceOver
+// 	Return TRUE if the running thread has run for at least the
+//	minimum granularity, and some ready thread has had less of the
+//	CPU than it has.
+//----------------------------------------------------------------------
+
+bool
+CFSPolicy::TimeSliceOver(Thread *thread)
+{
+    Charge(thread);
+    if (kernel->stats->totalTicks - thread->getStartTime() < minGranularity
+	    || readyTree->IsEmpty()) {
+	return FALSE;
+    }
+    return (LowerVruntime(readyTree->Front(), thread) < 0);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Switched
+// 	Charge the thread giving up the CPU for the rest of its time, and
+//	start counting the time of the one taking it over.  A thread that
+//	yielded was charged when it went back in the ready tree.  Either
+//	may be NULL, if the CPU goes idle, or has been idle.
+//----------------------------------------------------------------------
+
+void
+CFSPolicy::Switched(Thread *oldThread, Thread *nextThread)
+{
+    if (oldThread != NULL && oldThread->getStatus() != READY) {
+	Charge(oldThread);
+    }
+    if (nextThread != NULL) {
+	nextThread->vruntimeTicks = kernel->stats->totalTicks;
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFTask::EDFTask
+// 	Initialize the real-time parameters of a task, whose first job
+//	is released now.
+//
+//	"p" is the period, "d" the deadline and "b" the budget, in ticks
+//----------------------------------------------------------------------
+
+EDFTask::EDFTask(int p, int d, int b)
+{
+    period = p;
+    deadline = d;
+    budget = b;
+    release = usedTicks = kernel->stats->totalTicks;
+    used = 0;
+    counted = FALSE;
+}
+
+//----------------------------------------------------------------------
+// EarlierDeadline, EarlierRelease
+// 	Compare two real-time tasks by when their current jobs are due,
+//	or by when their next jobs are released, and if those are the
+//	same, by ID.
+//----------------------------------------------------------------------
+
+static int
+EarlierDeadline(Thread *a, Thread *b)
+{
+    if (a->edf->Due() != b->edf->Due()) {
+	return a->edf->Due() < b->edf->Due() ? -1 : 1;
+    }
+    if (a->getID() != b->getID()) {
+	return a->getID() < b->getID() ? -1 : 1;
+    }
+    return 0;
+}
+
+static int
+EarlierRelease(Thread *a, Thread *b)
+{
+    if (a->edf->NextRelease() != b->edf->NextRelease()) {
+	return a->edf->NextRelease() < b->edf->NextRelease() ? -1 : 1;
+    }
+    if (a->getID() != b->getID()) {
+	return a->getID() < b->getID() ? -1 : 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::EDFPolicy
+// 	Initialize empty ready queues, with no real-time tasks admitted.
+//----------------------------------------------------------------------
+
+EDFPolicy::EDFPolicy()
+{
+    readyList = new SortedList<Thread *>(EarlierDeadline);
+    throttledList = new SortedList<Thread *>(EarlierRelease);
+    backgroundList = new List<Thread *>;
+    utilization = 0;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::~EDFPolicy
+// 	De-allocate the ready queues.
+//----------------------------------------------------------------------
+
+EDFPolicy::~EDFPolicy()
+{
+    delete readyList;
+    delete throttledList;
+    delete backgroundList;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Charge
+// 	Add the ticks "thread" has run since it was last charged to the
+//	CPU used by its current job.
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::Charge(Thread *thread)
+{
+    EDFTask *task = thread->edf;
+    int now = kernel->stats->totalTicks;
+
+    task->used += now - task->usedTicks;
+    task->usedTicks = now;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::NewRelease
+// 	If the period of a task's current job is over, release the job
+//	of the period we are now in, with a fresh budget.  If the old
+//	job never finished, it missed its deadline.
+//
+//	"waited" -- TRUE if the task has been ready or running all
+//		along, so that each of the periods in between released
+//		a job too, and it missed that job's deadline as well;
+//		FALSE if it has been asleep
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::NewRelease(Thread *thread, bool waited)
+{
+    EDFTask *task = thread->edf;
+    int now = kernel->stats->totalTicks;
+    int periods, missed;
+
+    if (now < task->NextRelease()) {
+	return;
+    }
+    periods = (now - task->release) / task->period;
+    missed = (waited ? periods - 1 : 0) + (task->counted ? 0 : 1);
+    if (missed > 0) {
+	kernel->stats->numDeadlinesMissed += missed;
+	DEBUG(dbgThread, "EDF: " << thread->getName() << " missed " << missed
+			<< " deadlines, from " << task->Due());
+    }
+    task->release += periods * task->period;
+    task->used = 0;
+    task->counted = FALSE;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::ReleaseThrottled
+// 	Move the tasks that ran out of budget, and whose next job has
+//	now been released, back to the ready list.
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::ReleaseThrottled()
+{
+    int now = kernel->stats->totalTicks;
+
+    while (!throttledList->IsEmpty()
+		&& now >= throttledList->Front()->edf->NextRelease()) {
+	Thread *thread = throttledList->RemoveFront();
+
+	NewRelease(thread, TRUE);
+	readyList->Insert(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Insert
+// 	Put a thread in the ready queue it belongs in.  If it is the
+//	running thread, charge its job for its time first.  A job that
+//	has used up its budget waits for the next release.
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::Insert(Thread *thread)
+{
+    if (thread->edf == NULL) {
+	backgroundList->Append(thread);
+	return;
+    }
+    if (thread == kernel->currentThread) {
+	Charge(thread);
+    }
+    NewRelease(thread, thread == kernel->currentThread);
+    if (thread->edf->used < thread->edf->budget) {
+	readyList->Insert(thread);
+    } else {
+	throttledList->Insert(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::RemoveNext
+// 	Return the real-time task whose job is due first.  If there is
+//	none, return a thread that isn't real-time; if there is none of
+//	those either, rather than leave the CPU idle, return the task
+//	that ran out of budget whose next job is released first.  If no
+//	thread is ready at all, return NULL.
+//----------------------------------------------------------------------
+
+Thread *
+EDFPolicy::RemoveNext()
+{
+    ReleaseThrottled();
+    while (!readyList->IsEmpty()) {
+	Thread *thread = readyList->RemoveFront();
+
+	if (kernel->stats->totalTicks < thread->edf->NextRelease()) {
+	    return thread;
+	}
+	NewRelease(thread, TRUE);	// its job's period ended while it was
+	readyList->Insert(thread);	// waiting, so it has a new deadline
+    }
+    if (!backgroundList->IsEmpty()) {
+	return backgroundList->RemoveFront();
+    }
+    if (!throttledList->IsEmpty()) {
+	return throttledList->RemoveFront();
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::NumReady, NumReadyAt, Print
+// 	Count and print the threads in the ready queues: 1 is the jobs
+//	with budget left, 2 the ones out of budget, and 3 the threads
+//	that aren't real-time.
+//----------------------------------------------------------------------
+
+int
+EDFPolicy::NumReady()
+{
+    return readyList->NumInList() + throttledList->NumInList()
+				+ backgroundList->NumInList();
+}
+
+int
+EDFPolicy::NumReadyAt(int level)
+{
+    switch (level) {
+      case 1: return readyList->NumInList();
+      case 2: return throttledList->NumInList();
+      case 3: return backgroundList->NumInList();
+    }
+    return 0;
+}
+
+void
+EDFPolicy::Print()
+{
+    cout << "Ready: ";
+    readyList->Apply(ThreadPrint);
+    cout << "\nOut of budget: ";
+    throttledList->Apply(ThreadPrint);
+    cout << "\nBackground: ";
+    backgroundList->Apply(ThreadPrint);
+    cout << "\n";
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::TimeSliceOver
+// 	Return TRUE if the running thread should give up the CPU.  This
+//	is where budgets are enforced: a real-time task yields once its
+//	job has used up its budget, or once a job that is due earlier is
+//	ready.  Threads that aren't real-time yield at every timer 
+//	interrupt.
+//
+//	A task that never yields (say, the only one) only comes back 
+//	through Insert when it runs out of budget, so once its period is
+//	over, its next job is released here.
+//----------------------------------------------------------------------
+
+bool
+EDFPolicy::TimeSliceOver(Thread *thread)
+{
+    EDFTask *task = thread->edf;
+
+    if (task == NULL) {
+	return TRUE;
+    }
+    Charge(thread);
+    NewRelease(thread, TRUE);
+    if (task->used >= task->budget) {
+	return TRUE;
+    }
+    ReleaseThrottled();
+    return (!readyList->IsEmpty()
+		&& EarlierDeadline(readyList->Front(), thread) < 0);
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Blocked
+// 	A real-time task is going to sleep, so its current job is done:
+//	count whether it made its deadline.
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::Blocked(Thread *thread)
+{
+    EDFTask *task = thread->edf;
+
+    if (task == NULL) {
+	return;
+    }
+    Charge(thread);
+    if (!task->counted) {
+	if (kernel->stats->totalTicks <= task->Due()) {
+	    kernel->stats->numDeadlinesMet++;
+	} else {
+	    kernel->stats->numDeadlinesMissed++;
+	    DEBUG(dbgThread, "EDF: " << thread->getName()
+			<< " missed deadline " << task->Due());
+	}
+	task->counted = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Switched
+// 	Charge the thread giving up the CPU for the rest of its time, and
+//	start counting the time of the one taking it over.  A thread that
+//	yielded was charged when it went back in a ready queue.  Either
+//	may be NULL, if the CPU goes idle, or has been idle.
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::Switched(Thread *oldThread, Thread *nextThread)
+{
+    if (oldThread != NULL && oldThread->edf != NULL 
+		&& oldThread->getStatus() != READY) {
+	Charge(oldThread);
+    }
+    if (nextThread != NULL && nextThread->edf != NULL) {
+	nextThread->edf->usedTicks = kernel->stats->totalTicks;
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Finished
+// 	A real-time task is done: give back its share of the CPU.
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::Finished(Thread *thread)
+{
+    if (thread->edf != NULL) {
+	utilization -= thread->edf->Density();
+	delete thread->edf;
+	thread->edf = NULL;
+    }
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::Admit
+// 	Make the running thread a real-time task, or change its
+//	parameters, if every admitted task can still meet its deadlines.
+//	Return TRUE if it was admitted.
+//
+//	"period", "deadline" and "budget" are in ticks; the budget must
+//	fit in the deadline, and the deadline in the period.
+//----------------------------------------------------------------------
+
+bool
+EDFPolicy::Admit(Thread *thread, int period, int deadline, int budget)
+{
+    double density, old;
+
+    if (budget <= 0 || budget > deadline || deadline > period) {
+	return FALSE;
+    }
+    density = (double) budget / deadline;
+    old = (thread->edf != NULL) ? thread->edf->Density() : 0;
+    if (utilization - old + density > EDFUtilizationBound) {
+	DEBUG(dbgThread, "EDF: " << thread->getName() << " not admitted, "
+		<< "utilization would be " << utilization - old + density);
+	return FALSE;
+    }
+    utilization += density - old;
+    delete thread->edf;
+    thread->edf = new EDFTask(period, deadline, budget);
+    DEBUG(dbgThread, "EDF: " << thread->getName() << " admitted, "
+		<< "utilization " << utilization);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// EDFPolicy::SelfTest
+// 	Test admission control, on two threads that are never run: a
+//	task that would take the utilization over the bound is turned
+//	away, a task asking again is judged on its new share only, and
+//	a finished task gives its share back.  Then check that a task
+//	that has run on, alone, for several periods is charged a missed
+//	deadline for each.
+//
+//	The densities are exact binary fractions, so the sums are exact.
+//	The policy must not have admitted anything yet.
+//----------------------------------------------------------------------
+
+void
+EDFPolicy::SelfTest()
+{
+    Thread *a = new Thread("EDF test a", 1, SmallStack);
+    Thread *b = new Thread("EDF test b", 2, SmallStack);
+
+    ASSERT(utilization == 0);
+    ASSERT(!Admit(a, 100, 50, 60));	// budget doesn't fit the deadline
+    ASSERT(!Admit(a, 50, 100, 50));	// deadline doesn't fit the period
+    ASSERT(a->edf == NULL);
+
+    ASSERT(Admit(a, 100, 100, 50));		// 0.5
+    ASSERT(!Admit(b, 100, 100, 75));		// 0.5 + 0.75: over the bound
+    ASSERT(b->edf == NULL && utilization == 0.5);
+
+    ASSERT(Admit(a, 200, 100, 75));		// a again: 0.75, not 1.25
+    ASSERT(a->edf->period == 200 && a->edf->budget == 75);
+    ASSERT(utilization == 0.75);
+    ASSERT(!Admit(b, 100, 100, 50));		// 0.75 + 0.5
+
+    ASSERT(Admit(b, 100, 100, 25));		// 0.75 + 0.25: just fits
+    ASSERT(utilization == 1.0);
+    ASSERT(!Admit(a, 100, 100, 80));		// a again: 0.8 + 0.25 is over,
+    ASSERT(a->edf->budget == 75);		// so it keeps its old share
+    ASSERT(utilization == 1.0);
+
+    Finished(a);				// a's 0.75 back
+    ASSERT(a->edf == NULL && utilization == 0.25);
+    ASSERT(Admit(b, 100, 100, 100));		// b again: 1.0
+    Finished(b);
+    ASSERT(b->edf == NULL && utilization == 0);
+    Finished(b);				// not a task any more: no-op
+    ASSERT(utilization == 0);
+
+    // a lone task that never yields: at each timer interrupt, its job
+    // must be brought up to date, counting each period it fell behind
+    int now = kernel->stats->totalTicks;
+    int missed = kernel->stats->numDeadlinesMissed;
+
+    ASSERT(Admit(a, 100, 100, 50));
+    a->edf->release = now - 350;		// 3.5 periods ago, unfinished
+    a->edf->usedTicks = now;
+    ASSERT(!TimeSliceOver(a));			// a new job, with its budget
+    ASSERT(a->edf->release == now - 50 && a->edf->used == 0);
+    ASSERT(kernel->stats->numDeadlinesMissed == missed + 3);
+    ASSERT(!TimeSliceOver(a));			// nothing more to count
+    ASSERT(kernel->stats->numDeadlinesMissed == missed + 3);
+    kernel->stats->numDeadlinesMissed = missed;
+    Finished(a);
+    ASSERT(utilization == 0);
+
+    delete a;
+    delete b;
+}
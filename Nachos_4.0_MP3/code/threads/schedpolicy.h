@@ -0,0 +1,308 @@
+// schedpolicy.h
+//	Data structures for scheduling policies.
+//
+//	The scheduler (scheduler.h) does the mechanics of running
+//	threads: marking them ready, switching to them, and cleaning up
+//	after them.  A scheduling policy keeps the threads that are ready
+//	to run, and decides which one runs next, and for how long.
+//	Which policy to use is chosen with -sched (see Kernel::Kernel).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDPOLICY_H
+#define SCHEDPOLICY_H
+
+#include "copyright.h"
+#include "list.h"
+#include "rbtree.h"
+#include "thread.h"
+
+// The scheduling policies Nachos knows about.
+enum SchedPolicyType { SchedMultiLevel,	// MP3's three ready queues, L1-L3
+				// (see MultiLevelPolicy)
+		       SchedFIFO,	// first come, first served
+		       SchedRR,		// round robin
+		       SchedMLFQ,	// multi-level feedback queue
+		       SchedSJF,	// shortest (estimated) job first
+		       SchedLottery,	// lottery scheduling
+		       SchedStride,	// stride scheduling
+		       SchedCFS,	// completely fair scheduling
+		       SchedEDF		// earliest deadline first
+};
+
+const int NumMLFQLevels = 3;	// queues in the MLFQ policy
+const int MLFQBoostTicks = 5000;// how often the MLFQ policy moves every
+				// thread back to its top queue
+const unsigned int StrideOne = 1 << 16;
+				// stride of a thread with one ticket
+const int CFSNiceZeroWeight = 1024;
+				// CFS weight of a thread of middling
+				// priority (nice 0, in UNIX terms)
+const double EDFUtilizationBound = 1.0;
+				// share of the CPU that EDF may promise
+				// to real-time tasks
+
+// The following class defines the interface between the scheduler and
+// a scheduling policy.  Every routine is called with interrupts off.
+//
+// A thread's tickets (for lottery and stride scheduling) are its
+// priority plus one, so that every thread gets at least one.
+
+class SchedulingPolicy {
+  public:
+    virtual ~SchedulingPolicy() {}
+
+    virtual void Insert(Thread *thread) = 0;
+				// put a thread in the ready queue
+    virtual Thread *RemoveNext() = 0;
+				// take the thread to run next out of
+				// the ready queue; NULL if there are none
+    virtual int NumReady() = 0;	// how many threads are ready?
+    virtual int NumLevels() { return 1; }
+				// how many ready queues are there?
+    virtual int NumReadyAt(int level) { return NumReady(); }
+				// how many threads are in queue "level"
+				// (1 is the first)?
+    virtual void Print() = 0;	// print the ready queue, for debugging
+
+    virtual bool TimeSliceOver(Thread *thread) { return TRUE; }
+				// should "thread", which is running,
+				// yield at this timer interrupt?
+    virtual bool Preempts(Thread *next, Thread *current) { return TRUE; }
+				// "current" has yielded, and "next" has
+				// been picked to replace it.  Should it?
+				// If not, the policy puts "next" back,
+				// and takes "current" out of the queue.
+    virtual void Blocked(Thread *thread) {}
+				// "thread" is going to sleep
+    virtual void Switched(Thread *oldThread, Thread *nextThread) {}
+				// "oldThread" is giving the CPU to
+				// "nextThread" (on a multiprocessor,
+				// either may be NULL: see -ncpu)
+    virtual void Finished(Thread *thread) {}
+				// "thread" is done, and about to be
+				// destroyed
+    virtual bool Admit(Thread *thread, int period, int deadline,
+			int budget) { return FALSE; }
+				// make "thread" a real-time task;
+				// FALSE if the policy can't meet its
+				// deadlines (or has no notion of them)
+};
+
+// First come, first served: a thread runs until it blocks or yields.
+
+class FIFOPolicy : public SchedulingPolicy {
+  public:
+    FIFOPolicy() { readyList = new List<Thread *>; }
+    ~FIFOPolicy() { delete readyList; }
+
+    void Insert(Thread *thread) { readyList->Append(thread); }
+    Thread *RemoveNext();
+    int NumReady() { return readyList->NumInList(); }
+    void Print() { readyList->Apply(ThreadPrint); }
+
+    bool TimeSliceOver(Thread *thread) { return FALSE; }
+
+  protected:
+    List<Thread *> *readyList;	// threads ready to run, in order
+};
+
+// Round robin: first come, first served, but a thread that has run
+// for a quantum yields at the next timer interrupt.
+
+class RoundRobinPolicy : public FIFOPolicy {
+  public:
+    RoundRobinPolicy(int q) { quantum = q; }
+
+    bool TimeSliceOver(Thread *thread);
+
+  private:
+    int quantum;		// ticks a thread may run before yielding
+};
+
+// Multi-level feedback queue: a thread that uses up its time slice
+// moves down a queue, where the time slice is twice as long; threads
+// in higher queues always run first.  Every MLFQBoostTicks, every
+// thread is moved back to the top, so none starves.
+
+class MLFQPolicy : public SchedulingPolicy {
+  public:
+    MLFQPolicy(int q);		// "q": time slice of the top queue
+    ~MLFQPolicy();
+
+    void Insert(Thread *thread);
+    Thread *RemoveNext();
+    int NumReady();
+    void Print();
+    int NumLevels() { return NumMLFQLevels; }
+    int NumReadyAt(int level) { return queue[level - 1]->NumInList(); }
+
+    bool TimeSliceOver(Thread *thread);
+
+  private:
+    List<Thread *> *queue[NumMLFQLevels];
+				// queue[0] runs first
+    int quantum;		// time slice of queue[0]
+    int lastBoost;		// when every thread was last moved up
+
+    int Quantum(int level) { return quantum << level; }
+};
+
+// Shortest job first: run the thread whose next CPU burst is expected
+// to be shortest, until it blocks.  The guess is the average of the
+// last guess and the length of the burst that just ended.
+
+class SJFPolicy : public SchedulingPolicy {
+  public:
+    SJFPolicy();
+    ~SJFPolicy() { delete readyList; }
+
+    void Insert(Thread *thread) { readyList->Insert(thread); }
+    Thread *RemoveNext();
+    int NumReady() { return readyList->NumInList(); }
+    void Print() { readyList->Apply(ThreadPrint); }
+
+    bool TimeSliceOver(Thread *thread) { return FALSE; }
+    void Blocked(Thread *thread);
+
+  private:
+    SortedList<Thread *> *readyList;	// threads, shortest guess first
+};
+
+// Lottery scheduling: at each decision, draw one of the ready threads'
+// tickets at random, and run the thread that holds it.
+
+class LotteryPolicy : public FIFOPolicy {
+  public:
+    Thread *RemoveNext();
+
+    bool TimeSliceOver(Thread *thread) { return TRUE; }
+};
+
+// Stride scheduling: the deterministic version of lottery scheduling.
+// Each thread has a "pass"; the thread with the lowest pass runs next,
+// and its pass goes up by StrideOne divided by its tickets.
+
+class StridePolicy : public SchedulingPolicy {
+  public:
+    StridePolicy();
+    ~StridePolicy() { delete readyList; }
+
+    void Insert(Thread *thread);
+    Thread *RemoveNext();
+    int NumReady() { return readyList->NumInList(); }
+    void Print() { readyList->Apply(ThreadPrint); }
+
+  private:
+    SortedList<Thread *> *readyList;	// threads, lowest pass first
+    unsigned int globalPass;	// pass of the thread that ran last
+};
+
+// Completely fair scheduling, as in Linux: each thread's "virtual
+// runtime" goes up as it runs, more slowly the higher its priority,
+// and the thread with the lowest virtual runtime runs next.  The ready
+// threads are kept in a red-black tree, by virtual runtime.
+//
+// The running thread yields at a timer interrupt once it has run for
+// the minimum granularity, if some ready thread's virtual runtime is
+// then lower than its own.
+
+class CFSPolicy : public SchedulingPolicy {
+  public:
+    CFSPolicy(int granularity);	// "granularity": ticks a thread runs
+				// before it can be preempted
+    ~CFSPolicy() { delete readyTree; }
+
+    void Insert(Thread *thread);
+    Thread *RemoveNext();
+    int NumReady() { return readyTree->NumInTree(); }
+    void Print() { readyTree->Apply(ThreadPrint); }
+
+    bool TimeSliceOver(Thread *thread);
+    void Switched(Thread *oldThread, Thread *nextThread);
+
+  private:
+    RBTree<Thread *> *readyTree;// threads, lowest virtual runtime first
+    int minGranularity;		// ticks a thread runs before it can
+				// be preempted
+    unsigned int minVruntime;	// virtual runtime of the thread that
+				// ran last; never goes down
+
+    void Charge(Thread *thread);// add the time "thread" has run since
+				// it was last charged to its virtual
+				// runtime
+};
+
+// The real-time parameters of a thread, for EDF.  Every "period" ticks
+// from when it is admitted, the task releases a job, which needs up to
+// "budget" ticks of CPU within "deadline" ticks of its release.  A job
+// is done when the thread blocks.
+
+class EDFTask {
+  public:
+    EDFTask(int p, int d, int b);
+
+    int period;			// ticks between releases
+    int deadline;		// ticks after a release the job is due
+    int budget;			// ticks of CPU a job may use
+    int release;		// when the current job was released
+    int used;			// ticks of CPU the current job has used
+    int usedTicks;		// totalTicks when "used" was last
+				// brought up to date
+    bool counted;		// has the current job been counted as
+				// meeting or missing its deadline?
+
+    int NextRelease() { return release + period; }
+    int Due() { return release + deadline; }
+    double Density() { return (double) budget / deadline; }
+};
+
+// Earliest deadline first: of the real-time tasks whose current job
+// still has budget, run the one whose job is due first.  A job that
+// uses up its budget waits for the task's next release.  Threads that
+// are not real-time tasks run round robin, when no job is ready.
+//
+// A task is admitted only if the sum of every task's budget over its
+// deadline stays within EDFUtilizationBound, so that (with a bound of
+// 1) every job can finish in time.
+
+class EDFPolicy : public SchedulingPolicy {
+  public:
+    EDFPolicy();
+    ~EDFPolicy();
+
+    void Insert(Thread *thread);
+    Thread *RemoveNext();
+    int NumReady();
+    void Print();
+    int NumLevels() { return 3; }
+    int NumReadyAt(int level);
+
+    bool TimeSliceOver(Thread *thread);
+    void Blocked(Thread *thread);
+    void Switched(Thread *oldThread, Thread *nextThread);
+    void Finished(Thread *thread);
+    bool Admit(Thread *thread, int period, int deadline, int budget);
+
+    void SelfTest();		// test admission control
+
+  private:
+    SortedList<Thread *> *readyList;	// jobs with budget left, earliest
+					// deadline first
+    SortedList<Thread *> *throttledList;// jobs out of budget, earliest
+					// next release first
+    List<Thread *> *backgroundList;	// threads that aren't real-time
+    double utilization;		// sum of the admitted tasks' densities
+
+    void Charge(Thread *thread);// add the time "thread" has run since
+				// it was last charged to its job
+    void NewRelease(Thread *thread, bool waited);
+				// start the task's current job, if its
+				// last one's period is over
+    void ReleaseThrottled();	// move the tasks whose next job has been
+				// released back to the ready list
+};
+
+#endif // SCHEDPOLICY_H
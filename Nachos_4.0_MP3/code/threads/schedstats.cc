@@ -0,0 +1,237 @@
+// schedstats.cc
+//	Routines to record the scheduler's activity in memory, and write
+//	it out as CSV when Nachos halts.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "schedstats.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// ThreadSchedStats::ThreadSchedStats
+// 	Initialize the counters of a thread, which hasn't waited or run
+//	yet, as far as we know.
+//----------------------------------------------------------------------
+
+ThreadSchedStats::ThreadSchedStats(Thread *thread)
+{
+    id = thread->getID();
+    name = new char[strlen(thread->getName()) + 1];
+    strcpy(name, thread->getName());
+    priority = thread->getPriority();
+    waiting = FALSE;
+    readySince = kernel->stats->totalTicks;
+    waits = waitTicks = maxWait = 0;
+    bursts = runTicks = maxBurst = 0;
+    preemptions = 0;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::SchedStats
+// 	Start recording, with nothing recorded yet.
+//
+//	"prefix" is the start of the names of the CSV files
+//----------------------------------------------------------------------
+
+SchedStats::SchedStats(char *prefix)
+{
+    this->prefix = prefix;
+    threads = new List<ThreadSchedStats *>;
+    maxSamples = 1024;
+    samples = new int[maxSamples * (1 + MaxQueueLevels)];
+    numSamples = 0;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::~SchedStats
+// 	Nachos is halting: write out what has been recorded, and
+//	de-allocate it.
+//----------------------------------------------------------------------
+
+SchedStats::~SchedStats()
+{
+    WriteThreads();
+    WriteQueues();
+    while (!threads->IsEmpty()) {
+	ThreadSchedStats *record = threads->RemoveFront();
+
+	delete record;
+    }
+    delete threads;
+    delete [] samples;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Find
+// 	Return the counters of "thread", starting them if this is the
+//	first we've seen of it.
+//----------------------------------------------------------------------
+
+ThreadSchedStats *
+SchedStats::Find(Thread *thread)
+{
+    if (thread->schedStats == NULL) {
+	thread->schedStats = new ThreadSchedStats(thread);
+	threads->Append(thread->schedStats);
+    }
+    return thread->schedStats;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Ready
+// 	A thread was put on a ready queue: start timing its wait.  A
+//	thread that was already waiting, and was only moved from one
+//	queue to another (for instance, by MultiLevelPolicy::Preempts),
+//	keeps waiting from when it started.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Ready(Thread *thread)
+{
+    ThreadSchedStats *record = Find(thread);
+
+    if (thread == kernel->currentThread || !record->waiting) {
+	record->waiting = TRUE;
+	record->readySince = kernel->stats->totalTicks;
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Switch
+// 	"oldThread" has run since it last got the CPU, and is giving it
+//	to "nextThread", which has waited since it last became ready.  If
+//	"oldThread" is ready itself, it was preempted.  On a multiprocessor,
+//	either may be NULL, if the CPU goes idle, or has been idle.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Switch(Thread *oldThread, Thread *nextThread)
+{
+    int now = kernel->stats->totalTicks;
+
+    if (oldThread != NULL) {
+	ThreadSchedStats *old = Find(oldThread);
+	int burst = now - oldThread->getStartTime();
+
+	old->bursts++;
+	old->runTicks += burst;
+	if (burst > old->maxBurst) {
+	    old->maxBurst = burst;
+	}
+	if (oldThread->getStatus() == READY) {
+	    old->preemptions++;
+	} else {
+	    old->waiting = FALSE;
+	}
+    }
+    if (nextThread != NULL) {
+	ThreadSchedStats *next = Find(nextThread);
+	int wait = now - next->readySince;
+
+	next->waiting = FALSE;
+	next->waits++;
+	next->waitTicks += wait;
+	if (wait > next->maxWait) {
+	    next->maxWait = wait;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedStats::Sample
+// 	Record how many threads are in each of the scheduling policy's
+//	ready queues right now.  Called at each timer interrupt.
+//----------------------------------------------------------------------
+
+void
+SchedStats::Sample()
+{
+    int numLevels = kernel->scheduler->NumLevels();
+    int *sample;
+
+    ASSERT(numLevels <= MaxQueueLevels);
+    if (numSamples == maxSamples) {	// out of room: double it
+	int *bigger = new int[2 * maxSamples * (1 + MaxQueueLevels)];
+
+	bcopy(samples, bigger, maxSamples * (1 + MaxQueueLevels) * sizeof(int));
+	delete [] samples;
+	samples = bigger;
+	maxSamples *= 2;
+    }
+    sample = &samples[numSamples * (1 + MaxQueueLevels)];
+    sample[0] = kernel->stats->totalTicks;
+    for (int level = 1; level <= numLevels; level++) {
+	sample[level] = kernel->scheduler->NumReadyAt(level);
+    }
+    numSamples++;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::WriteThreads
+// 	Write the counters of every thread to <prefix>-threads.csv, one
+//	line per thread, in the order they were first seen.
+//----------------------------------------------------------------------
+
+void
+SchedStats::WriteThreads()
+{
+    ListIterator<ThreadSchedStats *> iter(threads);
+    char *fileName = new char[strlen(prefix) + 20];
+    char line[200];
+    int fd;
+
+    sprintf(fileName, "%s-threads.csv", prefix);
+    fd = OpenForWrite(fileName);
+    sprintf(line, "id,name,priority,waits,wait_ticks,max_wait,"
+		"bursts,run_ticks,max_burst,preemptions\n");
+    WriteFile(fd, line, strlen(line));
+    for (; !iter.IsDone(); iter.Next()) {
+	ThreadSchedStats *t = iter.Item();
+
+	sprintf(line, "%d,%.100s,%d,%d,%d,%d,%d,%d,%d,%d\n", t->id, t->name,
+		t->priority, t->waits, t->waitTicks, t->maxWait,
+		t->bursts, t->runTicks, t->maxBurst, t->preemptions);
+	WriteFile(fd, line, strlen(line));
+    }
+    Close(fd);
+    delete [] fileName;
+}
+
+//----------------------------------------------------------------------
+// SchedStats::WriteQueues
+// 	Write the queue length samples to <prefix>-queues.csv, one line
+//	per sample: the tick, then the length of queue L1, L2, ...
+//----------------------------------------------------------------------
+
+void
+SchedStats::WriteQueues()
+{
+    int numLevels = kernel->scheduler->NumLevels();
+    char *fileName = new char[strlen(prefix) + 20];
+    char line[100];
+    int fd;
+
+    sprintf(fileName, "%s-queues.csv", prefix);
+    fd = OpenForWrite(fileName);
+    sprintf(line, "tick");
+    for (int level = 1; level <= numLevels; level++) {
+	sprintf(line + strlen(line), ",L%d", level);
+    }
+    strcat(line, "\n");
+    WriteFile(fd, line, strlen(line));
+    for (int i = 0; i < numSamples; i++) {
+	int *sample = &samples[i * (1 + MaxQueueLevels)];
+
+	sprintf(line, "%d", sample[0]);
+	for (int level = 1; level <= numLevels; level++) {
+	    sprintf(line + strlen(line), ",%d", sample[level]);
+	}
+	strcat(line, "\n");
+	WriteFile(fd, line, strlen(line));
+    }
+    Close(fd);
+    delete [] fileName;
+}
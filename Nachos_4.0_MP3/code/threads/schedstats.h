@@ -0,0 +1,93 @@
+// schedstats.h
+//	Data structures for recording what the scheduler does, for
+//	analysis after Nachos halts.
+//
+//	With -schedstats, instead of printing a "Tick [...]" line each
+//	time a thread moves between the ready queues and the CPU, the
+//	scheduler keeps counters for each thread -- how long it waited
+//	to run, how long it ran, how often it was preempted -- and
+//	samples the length of each ready queue at every timer interrupt.
+//	When the kernel shuts down, they are written out as CSV files.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDSTATS_H
+#define SCHEDSTATS_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+
+const int MaxQueueLevels = 3;	// most ready queues a policy can have
+
+//----------------------------------------------------------------------
+// SCHED_TRACE
+//      Print one of MP3's "Tick [...]" lines about the scheduler,
+//	unless its activity is being recorded by -schedstats instead.
+//
+//	Wrapped in do ... while (0), so that it is a single statement,
+//	and can be the body of an if without braces.
+//----------------------------------------------------------------------
+#define SCHED_TRACE(expr)                                                  \
+    do {								\
+	if (kernel->schedStats == NULL) {				\
+	    cout << "Tick [" << kernel->stats->totalTicks << "] : " << expr \
+		<< endl;						\
+	}								\
+    } while (0)
+
+// The scheduling counters of one thread.  They outlive the thread, so
+// they can be written out when Nachos halts.
+
+class ThreadSchedStats {
+  public:
+    ThreadSchedStats(Thread *thread);
+    ~ThreadSchedStats() { delete [] name; }
+
+    int id;			// the thread's ID
+    char *name;			// a copy of its name
+    int priority;		// its priority when it was first seen
+    bool waiting;		// is it waiting on a ready queue?
+    int readySince;		// if so, since when
+    int waits;			// times it waited on a ready queue
+    int waitTicks;		// total and longest time it waited
+    int maxWait;
+    int bursts;			// times it ran on the CPU
+    int runTicks;		// total and longest time it ran
+    int maxBurst;
+    int preemptions;		// times it gave up the CPU while it
+				// could still run
+};
+
+// The following class records the scheduler's activity.  Each routine
+// is called with interrupts off, and takes constant time, so recording
+// costs much less than printing.
+
+class SchedStats {
+  public:
+    SchedStats(char *prefix);	// "prefix" names the CSV files
+    ~SchedStats();		// write the CSV files, and clean up
+
+    void Ready(Thread *thread);	// "thread" was put on a ready queue
+    void Switch(Thread *oldThread, Thread *nextThread);
+				// "oldThread" gave the CPU to "nextThread"
+    void Sample();		// record the length of each ready queue
+
+  private:
+    char *prefix;		// CSV files are <prefix>-threads.csv
+				// and <prefix>-queues.csv
+    List<ThreadSchedStats *> *threads;
+				// counters of every thread seen
+    int *samples;		// tick and queue lengths of each sample
+    int numSamples;		// samples taken so far
+    int maxSamples;		// samples there is room for
+
+    ThreadSchedStats *Find(Thread *thread);
+				// the counters of "thread"
+    void WriteThreads();	// write out the per-thread counters
+    void WriteQueues();		// write out the queue length samples
+};
+
+#endif // SCHEDSTATS_H
@@ -14,6 +14,21 @@
 // 	Very simple implementation -- no priorities, straight FIFO.
 //	Might need to be improved in later assignments.
 //
+//	With -ncpu, the machine has several CPUs, each with a thread
+//	running on it and a ready queue of its own.  Only one CPU is
+//	simulated at a time (and that is still a uniprocessor, as far as
+//	mutual exclusion goes); the others are paused, each with its own
+//	simulated time, and at every timer interrupt (and whenever its
+//	thread gives it up) the CPU that is furthest behind in simulated
+//	time takes over.  So device interrupts, which are scheduled in
+//	simulated time, never happen before a CPU has caught up with
+//	them.  A CPU that runs out of ready threads steals one from the
+//	busiest other CPU.
+//
+//	With -parallel, the CPUs' user code also runs on host threads,
+//	so that several host cores share the work (see RunAhead).  The
+//	kernel itself still runs on one host thread, one CPU at a time.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -22,50 +37,108 @@
 #include "debug.h"
 #include "scheduler.h"
 #include "main.h"
+#include "bitmap.h"
+#include "schedstats.h"
+#include <strings.h>
+#include <limits.h>
 
 #define AGING 10
 // define aging increase by 10
+#define AGING_TIME 1500
+// define how long a thread waits before it ages
 //#define REINSERT(LIST, t) LIST ## _ReadyList->Remove(t); LIST ## _ReadyList->Insert(t)
 //#define REAPPEND(LIST, t) LIST ## _ReadyList->Remove(t); LIST ## _ReadyList->Append(t)
 
 
 //----------------------------------------------------------------------
-// Scheduler::Scheduler
-// 	Initialize the list of ready but not running threads.
-//	Initially, no ready threads.
+// MultiLevelPolicy::MultiLevelPolicy
+// 	Initialize the three ready queues.  Initially, no ready threads.
 //----------------------------------------------------------------------
 
 // Chanwei add
 int SJF(Thread *a, Thread *b){
 	double ta = a->getBurstTime(), tb = b->getBurstTime();
-	if(ta == tb)
-		return a->getID() < b->getID() ? -1 : 1;
+	if(ta == tb){
 		// if burst time are the same, compare the ID and return it
+		// (0 if the same ID -- the L1 tree needs that to find a thread)
+		if(a->getID() == b->getID())
+			return 0;
+		return a->getID() < b->getID() ? -1 : 1;
+	}
 	return ta < tb ? -1 : 1;
 }
 
+// threads with the same priority are run in order of ID (the
+// PriorityArray keeps its lists in that order too)
 int Priority_Job(Thread *a, Thread *b)
 {
-    int pa = a->getPriority(), pb = b->getPriority();
-    if(pa == pb)
-        return a->getID() < b->getID() ? -1 : 1;
-		// simply compare its ID
-	return pa > pb ? -1 : 1;
+    if(a->getID() == b->getID())
+        return 0;
+    return a->getID() < b->getID() ? -1 : 1;
+}
+
+static int QueueOrder(Thread *a, Thread *b);
+
+MultiLevelPolicy::MultiLevelPolicy()
+{
+    SJF_ReadyList = new RBTree<Thread *>(SJF);
+    PJ_ReadyList = new PriorityArray(50, 99);
+    RR_ReadyList = new List<Thread *>;
+    oldestReady = newestReady = NULL;
+    dueToAge = new SortedList<Thread *>(QueueOrder);
+}
+// end Chanwei add
+
+//----------------------------------------------------------------------
+// Scheduler::Scheduler
+// 	Initialize the list of ready but not running threads.
+//	Initially, no ready threads.
+//
+//	"type" -- the policy that decides which ready thread runs next
+//	"quantum" -- how many ticks a thread runs before it is preempted,
+//		for the policies that use time slices of their own
+//	"numCPUs" -- how many CPUs there are; the current thread is
+//		running on the first one
+//----------------------------------------------------------------------
+
+static SchedulingPolicy *
+NewPolicy(SchedPolicyType type, int quantum)
+{
+    switch (type) {
+      case SchedMultiLevel: return new MultiLevelPolicy;
+      case SchedFIFO:	    return new FIFOPolicy;
+      case SchedRR:	    return new RoundRobinPolicy(quantum);
+      case SchedMLFQ:	    return new MLFQPolicy(quantum);
+      case SchedSJF:	    return new SJFPolicy;
+      case SchedLottery:    return new LotteryPolicy;
+      case SchedStride:	    return new StridePolicy;
+      case SchedCFS:	    return new CFSPolicy(quantum);
+      case SchedEDF:	    return new EDFPolicy;
+      default:		    ASSERT(FALSE);
+    }
+    return NULL;
 }
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(SchedPolicyType type, int quantum, int numCPUs)
 {
-    readyList = new List<Thread *>;
+    ASSERT(numCPUs >= 1 && numCPUs <= MaxCPUs);
+    this->numCPUs = numCPUs;
+    cpus = new CPU *[numCPUs];
+    for (int i = 0; i < numCPUs; i++) {
+	cpus[i] = new CPU(i, NewPolicy(type, quantum));
+    }
+    currentCPU = cpus[0];
+    currentCPU->thread = kernel->currentThread;
+    kernel->currentThread->cpu = 0;
+    kernel->stats->numCPUs = numCPUs;
+    endingTurn = FALSE;
+    parallelTicks = 0;
+    this->quantum = quantum;
     // Chanwei add
     intHandler = new SchedulerIntHandler();
-    SJF_ReadyList = new SortedList<Thread *>(SJF);
-    PJ_ReadyList = new SortedList<Thread *>(Priority_Job);
-    RR_ReadyList = new List<Thread *>;
     // end Chanwei add
     toBeDestroyed = NULL;
 }
-// end Chanwei add
-
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
@@ -74,12 +147,25 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    delete readyList; 
+    for (int i = 0; i < numCPUs; i++) {
+	delete cpus[i];
+    }
+    delete [] cpus;
+} 
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::~MultiLevelPolicy
+// 	De-allocate the ready queues.
+//----------------------------------------------------------------------
+
+MultiLevelPolicy::~MultiLevelPolicy()
+{ 
 	// Chanwei add
 	delete SJF_ReadyList;
 	delete PJ_ReadyList;
 	delete RR_ReadyList;
 	// end Chanwei add
+    delete dueToAge;
 } 
 
 //----------------------------------------------------------------------
@@ -87,7 +173,9 @@ Scheduler::~Scheduler()
 // 	Mark a thread as ready, but not running.
 //	Put it on the ready list, for later scheduling onto the CPU.
 //
-//	"thread" is the thread to be put on the ready list.
+//	"thread" is the thread to be put on the ready list.  It goes
+//	on the list of the CPU it last ran on; a new thread, on the
+//	list of the current CPU.
 //----------------------------------------------------------------------
 
 void
@@ -96,11 +184,29 @@ Scheduler::ReadyToRun (Thread *thread)
     ASSERT(kernel->interrupt->getLevel() == IntOff);
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
     
+    if (thread->cpu < 0) {
+	thread->cpu = currentCPU->id;
+    }
+    thread->setStatus(READY);
+    cpus[thread->cpu]->policy->Insert(thread);
+    if (kernel->schedStats != NULL) {
+	kernel->schedStats->Ready(thread);
+    }
+
+    kernel->alarm->ThreadReady();	// may need time slices again
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Insert
+// 	Put a thread in the ready queue for its priority.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::Insert(Thread *thread)
+{
 	// Chanwei add
-	Thread *curThread = kernel->currentThread;
 	int currentTime = kernel->stats->totalTicks;
     int p = thread->getPriority();
-	thread->setStatus(READY);
     thread->setReadyTime(currentTime);
 
 	if(p >= 100){
@@ -116,12 +222,70 @@ Scheduler::ReadyToRun (Thread *thread)
         InsertToQueue(thread, 3);
     }
 	// end Chanwei add
-	
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NumReady
+// 	Return the number of threads on the ready lists.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NumReady()
+{
+    int num = 0;
+
+    for (int i = 0; i < numCPUs; i++) {
+	num += cpus[i]->policy->NumReady();
+    }
+    return num;
+}
+
+int
+MultiLevelPolicy::NumReady()
+{
+    return SJF_ReadyList->NumInTree() + PJ_ReadyList->NumInArray()
+		+ RR_ReadyList->NumInList();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NumLevels, NumReadyAt
+// 	Return how many ready queues the policy has, and how many
+//	threads are in ready queue "level" (1 is the first), on all
+//	the CPUs.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NumLevels()
+{
+    return cpus[0]->policy->NumLevels();
+}
+
+int
+Scheduler::NumReadyAt(int level)
+{
+    int num = 0;
+
+    for (int i = 0; i < numCPUs; i++) {
+	num += cpus[i]->policy->NumReadyAt(level);
+    }
+    return num;
+}
+
+int
+MultiLevelPolicy::NumReadyAt(int level)
+{
+    switch (level) {
+      case 1: return SJF_ReadyList->NumInTree();
+      case 2: return PJ_ReadyList->NumInArray();
+      case 3: return RR_ReadyList->NumInList();
+    }
+    return 0;
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
-// 	Return the next thread to be scheduled onto the CPU.
+// 	Return the next thread to be scheduled onto the current CPU:
+//	from its own ready list, or else stolen from another CPU's.
 //	If there are no ready threads, return NULL.
 // Side effect:
 //	Thread is removed from the ready list.
@@ -130,27 +294,86 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
+    Thread *thread;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
-	int currentTime = kernel->stats->totalTicks;
+
+    thread = currentCPU->policy->RemoveNext();
+    if (thread == NULL && numCPUs > 1) {
+	thread = Steal(currentCPU);
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Steal
+// 	"thief" has nothing to run: take the thread that the CPU with
+//	the most ready threads would run next, if there is one, and make
+//	it thief's from now on.  Return NULL if no other CPU has a ready
+//	thread.
+//
+//	A real-time task is not taken: it was admitted by its own CPU's
+//	policy (see Admit), which is counting on it.  It goes back where
+//	it was.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::Steal(CPU *thief)
+{
+    CPU *victim = NULL;
+    Thread *thread;
+
+    for (int i = 0; i < numCPUs; i++) {
+	int num = cpus[i]->policy->NumReady();
+
+	if (cpus[i] != thief && num > 0 
+		&& (victim == NULL || num > victim->policy->NumReady())) {
+	    victim = cpus[i];
+	}
+    }
+    if (victim == NULL || (thread = victim->policy->RemoveNext()) == NULL) {
+	return NULL;
+    }
+    if (thread->edf != NULL) {
+	victim->policy->Insert(thread);
+	return NULL;
+    }
+    DEBUG(dbgThread, "CPU " << thief->id << " steals " << thread->getName()
+		<< " from CPU " << victim->id);
+    thread->cpu = thief->id;
+    kernel->stats->cpuSteals[thief->id]++;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::RemoveNext
+// 	Age the threads that are due, and then take the first thread
+//	out of the highest non-empty queue.
+//----------------------------------------------------------------------
+
+Thread *
+MultiLevelPolicy::RemoveNext()
+{
     Thread* t = NULL;
 
 	// Chanwei comment and add
 	
-	Aging(SJF_ReadyList);
-    Aging(PJ_ReadyList);
-    Aging(RR_ReadyList);
+	Age();
 
 	if(!(SJF_ReadyList->IsEmpty())){
         t = SJF_ReadyList->RemoveFront();
-		cout << "Tick [" << currentTime << "] : Thread " << t->getID() << " is removed from queue L1" << endl;
+		StopWaiting(t);
+		SCHED_TRACE("Thread " << t->getID() << " is removed from queue L1");
     } 
 	else if(!(PJ_ReadyList->IsEmpty())){
         t = PJ_ReadyList->RemoveFront();
-		cout << "Tick [" << currentTime << "] : Thread " << t->getID() << " is removed from queue L2" << endl;
+		StopWaiting(t);
+		SCHED_TRACE("Thread " << t->getID() << " is removed from queue L2");
 	} 
 	else if(!RR_ReadyList->IsEmpty()){
         t = RR_ReadyList->RemoveFront();
-    	cout << "Tick [" << currentTime << "] : Thread " << t->getID() << " is removed from queue L3" << endl;
+		StopWaiting(t);
+    	SCHED_TRACE("Thread " << t->getID() << " is removed from queue L3");
 	}
 
     return t;
@@ -165,6 +388,11 @@ Scheduler::FindNextToRun ()
 //
 //      Note: we assume the state of the previously running thread has
 //	already been changed from running to blocked or ready (depending).
+//
+//	On a multiprocessor, the current CPU is given to nextThread, and
+//	then whichever CPU is furthest behind is simulated (see NextCPU),
+//	so the thread we switch to may be another CPU's.  nextThread may
+//	be NULL, leaving the current CPU idle, if another CPU is busy.
 // Side effect:
 //	The global variable kernel->currentThread becomes nextThread.
 //
@@ -184,40 +412,84 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     if (finishing) {	// mark that we need to delete current thread
          ASSERT(toBeDestroyed == NULL);
 	 toBeDestroyed = oldThread;
+	 cpus[oldThread->cpu]->policy->Finished(oldThread);
     }
     
-    if (oldThread->space != NULL) {	// if this thread is a user program,
-        oldThread->SaveUserState(); 	// save the user's CPU registers
-	oldThread->space->SaveState();
+    Account(currentCPU, oldThread, nextThread);
+    if (numCPUs > 1) {
+	nextThread = NextCPU();
     }
-    
-    oldThread->CheckOverflow();		    // check if the old thread
-					    // had an undetected stack overflow
+    Dispatch(oldThread, nextThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Account
+// 	Keep the books as "oldThread" gives "cpu" to "nextThread": how
+//	long the old thread ran, and when the next one started.  On a
+//	multiprocessor, either may be NULL, if "cpu" is going idle, or
+//	has been idle until now.
+//----------------------------------------------------------------------
 
+void
+Scheduler::Account(CPU *cpu, Thread *oldThread, Thread *nextThread)
+{
 	// Chanwei add
 	int currentTime = kernel->stats->totalTicks;
-	int executionTime = currentTime - oldThread->getStartTime();
 
-	if(!oldThread->isSleep()){	// if didn't sleep, calculate execution time here
+	if (oldThread != NULL) {
+	    int executionTime = currentTime - oldThread->getStartTime();
+
+	    if(!oldThread->isSleep()){	// if didn't sleep, calculate execution time here
 		oldThread->setExecutionTime(executionTime);
+	    }
+	    if(oldThread->isPreempted()) {
+		oldThread->addLastBurst(executionTime);
+		oldThread->resetPreempt();
+	    }
+	}
+	if (kernel->schedStats != NULL) {
+	    kernel->schedStats->Switch(oldThread, nextThread);
+	}
+	if (nextThread != NULL) {
+	    nextThread->setStartTime(currentTime);
 	}
+	cpu->policy->Switched(oldThread, nextThread);
+	cpu->thread = nextThread;
+	cpu->userPaused = FALSE;	// nextThread is in the kernel
+	if (nextThread != NULL) {
+	    nextThread->setStatus(RUNNING);      // nextThread is now running
+	    SCHED_TRACE("Thread " << nextThread->getID() << " is now selected for execution");
+	    if(oldThread != NULL && nextThread->getPriority() >= 100) {
+		SCHED_TRACE("Thread " << oldThread->getID() << " is replaced, and it has executed " << oldThread->getExecutionTime() << " ticks");
+	    }
+	}
+	if (oldThread != NULL) {
+	    oldThread->resetSleep();
+	}
+	// end Chanwei add
+}
 
-    if(oldThread->isPreempted()) {
-        oldThread->addLastBurst(executionTime);
-        oldThread->resetPreempt();
+//----------------------------------------------------------------------
+// Scheduler::Dispatch
+// 	Switch the machine from running "oldThread" to "nextThread".
+//	Save the state of the old thread, and load the state of the new
+//	thread, by calling the machine dependent context switch routine,
+//	SWITCH.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Dispatch(Thread *oldThread, Thread *nextThread)
+{
+    if (oldThread->space != NULL) {	// if this thread is a user program,
+        oldThread->SaveUserState(); 	// save the user's CPU registers
+	oldThread->space->SaveState();
     }
-	
-	nextThread->setStartTime(currentTime);
-	kernel->currentThread = nextThread;  // switch to the next thread
-    nextThread->setStatus(RUNNING);      // nextThread is now running
     
-	cout << "Tick [" << currentTime << "] : Thread " << nextThread->getID() << " is now selected for execution" << endl;
-	if(nextThread->getPriority() >= 100)		
-		//cout << "Thread " << nextThread->getID() << " Burst: " << nextThread->getBurstTime() << endl;
-	cout << "Tick [" << currentTime << "] : Thread " << oldThread->getID() << " is replaced, and it has executed " << oldThread->getExecutionTime() << " ticks" << endl;	
-	oldThread->resetSleep();
-	// end Chanwei add
-	
+    oldThread->CheckOverflow();		    // check if the old thread
+					    // had an undetected stack overflow
+
+    kernel->currentThread = nextThread;  // switch to the next thread
+
     DEBUG(dbgThread, "Switching from: " << oldThread->getName() << " to: " << nextThread->getName());
     
     // This is a machine-dependent assembly language routine defined 
@@ -244,6 +516,242 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     }
 }
 
+//----------------------------------------------------------------------
+// Scheduler::NextCPU
+// 	Pause the current CPU, and pick the CPU to simulate next: of
+//	those with a thread to run, the one furthest behind in simulated
+//	time (the first after the current one, if there's a tie).
+//
+//	An idle CPU has been idle until now.  If there is a ready thread,
+//	on its own list or (see Steal) another CPU's, it starts running
+//	it now.  With -parallel, the CPUs that were paused in user code
+//	then run ahead, before we pick one.
+//
+//	Return the thread running on the CPU that is now current.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::NextCPU()
+{
+    Statistics *stats = kernel->stats;
+    int now = stats->totalTicks;
+    CPU *next = NULL;
+
+    stats->cpuTicks[currentCPU->id] = now;
+    currentCPU->userPaused = kernel->interrupt->YieldingFromUser()
+			&& currentCPU->thread == kernel->currentThread;
+    for (int i = 1; i <= numCPUs; i++) {
+	CPU *cpu = cpus[(currentCPU->id + i) % numCPUs];
+	Thread *thread;
+
+	if (cpu->thread != NULL) {
+	    continue;
+	}
+	if (stats->cpuTicks[cpu->id] < now) {
+	    stats->cpuIdleTicks[cpu->id] += now - stats->cpuTicks[cpu->id];
+	    stats->cpuTicks[cpu->id] = now;
+	}
+	if ((thread = cpu->policy->RemoveNext()) != NULL
+		    || (thread = Steal(cpu)) != NULL) {
+	    Account(cpu, NULL, thread);
+	}				// else it stays idle
+    }
+    if (parallelTicks > 0) {
+	RunAhead();
+    }
+    for (int i = 1; i <= numCPUs; i++) {
+	CPU *cpu = cpus[(currentCPU->id + i) % numCPUs];
+
+	if (cpu->thread != NULL && (next == NULL 
+		|| stats->cpuTicks[cpu->id] < stats->cpuTicks[next->id])) {
+	    next = cpu;
+	}
+    }
+    ASSERT(next != NULL);
+    if (next != currentCPU) {
+	DEBUG(dbgThread, "Pausing CPU " << currentCPU->id << " at " 
+		<< stats->cpuTicks[currentCPU->id] << ", resuming CPU " 
+		<< next->id << " at " << stats->cpuTicks[next->id]);
+	currentCPU = next;
+	stats->currentCPU = next->id;
+	stats->totalTicks = stats->cpuTicks[next->id];
+	kernel->interrupt->SliceForward();	// it gets a whole time slice
+    } else {
+	stats->totalTicks = stats->cpuTicks[next->id];	// it may have run
+    }							// ahead
+    return currentCPU->thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RunInParallel
+// 	Give each CPU a host thread, to run its user code while the
+//	kernel is busy with other CPUs, or just doing nothing but wait
+//	for them (see RunAhead).  Must be called after the machine is
+//	set up, as the CPUs share its memory and cost model.
+//
+//	"window" -- how many ticks a CPU may get ahead of the CPU that
+//		is furthest behind, before it must wait for the kernel;
+//		no more than the time slice, so that a thread's time
+//		slice can't end more than one slice late (see RunAhead)
+//----------------------------------------------------------------------
+
+void
+Scheduler::RunInParallel(int window)
+{
+    ASSERT(numCPUs > 1 && window > 0);
+    for (int i = 0; i < numCPUs; i++) {
+	cpus[i]->host = new HostCPU(i, kernel->machine);
+    }
+    if (window > quantum) {
+	DEBUG(dbgThread, "Parallel window " << window
+		<< " cut to the time slice, " << quantum);
+	window = quantum;
+    }
+    parallelTicks = window;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RunAhead
+// 	Run the user code of every CPU that was paused between two of
+//	its thread's user instructions, on the CPUs' host threads, all
+//	at the same time.  Each runs until its thread needs the kernel,
+//	or its clock reaches the end of the window: "parallelTicks"
+//	after the CPU that is furthest behind, but no later than the
+//	next device interrupt.  The kernel's host thread waits for them.
+//
+//	This is a conservative barrier: until then, nothing but user
+//	code can happen, and user programs don't share memory, so they
+//	run just as they would one at a time.  When the CPUs are
+//	simulated again, they are all at least as far as the barrier,
+//	and whatever is due happens then.
+//
+//	But the timer doesn't end anyone's turn in the window: so, with
+//	-parallel, a thread's time slice is checked only once per window,
+//	not once every TimerTicks.  The wider the window, the more work
+//	there is for each host thread per barrier, and the coarser the
+//	time slicing -- which is why RunInParallel keeps the window no
+//	wider than a time slice.
+//----------------------------------------------------------------------
+
+void
+Scheduler::RunAhead()
+{
+    Statistics *stats = kernel->stats;
+    CPU *running[MaxCPUs];
+    int numRunning = 0;
+    int start = INT_MAX;
+    int until;
+
+    for (int i = 0; i < numCPUs; i++) {
+	if (stats->cpuTicks[i] < start) {
+	    start = stats->cpuTicks[i];
+	}
+    }
+    until = start + parallelTicks;
+    if (kernel->interrupt->DeviceHorizon() < until) {
+	until = kernel->interrupt->DeviceHorizon();
+    }
+    for (int i = 0; i < numCPUs; i++) {
+	CPU *cpu = cpus[i];
+
+	if (cpu->thread != NULL && cpu->userPaused 
+		&& stats->cpuTicks[i] < until) {
+	    running[numRunning++] = cpu;
+	}
+    }
+    if (numRunning < 2) {
+	return;				// just simulate them as usual
+    }
+    DEBUG(dbgThread, "Running " << numRunning << " CPUs ahead, from " 
+		<< start << " to " << until);
+    for (int i = 0; i < numRunning; i++) {
+	CPU *cpu = running[i];
+	HostCPU *host = cpu->host;
+
+	if (cpu->thread == kernel->currentThread) {
+	    cpu->thread->SaveUserState();	// still in the machine
+	}
+	cpu->thread->RestoreUserState(host->machine);
+	cpu->thread->space->RestoreState(host->machine);
+	host->stats->totalTicks = stats->cpuTicks[cpu->id];
+	host->Start(until);
+    }
+    for (int i = 0; i < numRunning; i++) {
+	CPU *cpu = running[i];
+	HostCPU *host = cpu->host;
+
+	host->Wait();
+	cpu->thread->SaveUserState(host->machine);
+	if (cpu->thread == kernel->currentThread) {
+	    cpu->thread->RestoreUserState();
+	}
+	stats->cpuTicks[cpu->id] = host->stats->totalTicks;
+	stats->userTicks += host->stats->userTicks;
+	stats->numUserInstructions += host->stats->numUserInstructions;
+	stats->parallelInstructions += host->stats->numUserInstructions;
+	host->stats->userTicks = host->stats->numUserInstructions = 0;
+    }
+    stats->parallelRounds++;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SwitchCPU
+// 	The current CPU's turn is over, but its thread keeps it: if
+//	another CPU is further behind, simulate that one instead.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchCPU()
+{
+    Thread *oldThread = kernel->currentThread;
+    Thread *nextThread;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (numCPUs == 1) {
+	return;
+    }
+    nextThread = NextCPU();
+    if (nextThread != oldThread) {
+	Dispatch(oldThread, nextThread);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EndingTurn
+// 	Return TRUE if EndTurn was called since we last looked: the
+//	timer says it's time to simulate another CPU, but the current 
+//	thread's time slice isn't over.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::EndingTurn()
+{
+    bool ending = endingTurn;
+
+    endingTurn = FALSE;
+    return ending;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NumRunningElsewhere
+// 	Return the number of threads running on CPUs other than the
+//	current one.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NumRunningElsewhere()
+{
+    int num = 0;
+
+    for (int i = 0; i < numCPUs; i++) {
+	if (cpus[i] != currentCPU && cpus[i]->thread != NULL) {
+	    num++;
+	}
+    }
+    return num;
+}
+
 //----------------------------------------------------------------------
 // Scheduler::CheckToBeDestroyed
 // 	If the old thread gave up the processor because it was finishing,
@@ -270,42 +778,281 @@ void
 Scheduler::Print()
 {
     cout << "Ready list contents:\n";
-    readyList->Apply(ThreadPrint);
+    for (int i = 0; i < numCPUs; i++) {
+	if (numCPUs > 1) {
+	    cout << "CPU " << i << ":\n";
+	}
+	cpus[i]->policy->Print();
+    }
+}
+
+void
+MultiLevelPolicy::Print()
+{
+    cout << "L1: ";
+    SJF_ReadyList->Apply(ThreadPrint);
+    cout << "\nL2: " << PJ_ReadyList->NumInArray() << " threads";
+    cout << "\nL3: ";
+    RR_ReadyList->Apply(ThreadPrint);
+    cout << "\n";
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TimeSliceOver
+// 	Return TRUE if the current thread should give up the CPU at this
+//	timer interrupt.  Called by the alarm clock.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::TimeSliceOver()
+{
+    return currentCPU->policy->TimeSliceOver(kernel->currentThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Preempts
+// 	The current thread has yielded, and "next" has been chosen to
+//	run in its place.  Return TRUE if the switch should go ahead; if
+//	not, the policy has put "next" back on the ready list, and 
+//	"current" keeps running.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Preempts(Thread *next, Thread *current)
+{
+    return currentCPU->policy->Preempts(next, current);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Blocked
+// 	Let the policy know that the current thread is about to sleep,
+//	so its CPU burst is over.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Blocked(Thread *thread)
+{
+    currentCPU->policy->Blocked(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Admit
+// 	Ask the policy to make "thread" a real-time task, which needs
+//	"budget" ticks of CPU within "deadline" ticks, every "period"
+//	ticks.  Return TRUE if the policy promises to meet its deadlines.
+//
+//	On a multiprocessor, each CPU's policy only admits the tasks it
+//	can schedule itself, against its own bound; a task stays on the
+//	CPU that admitted it (see Steal), and gives its share back there
+//	(see Run).
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Admit(Thread *thread, int period, int deadline, int budget)
+{
+    return cpus[thread->cpu]->policy->Admit(thread, period, deadline, 
+								budget);
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Preempts
+// 	A thread in L1 only gives the CPU to one with a burst no longer
+//	than its own, and a thread in L2 to one with at least its
+//	priority; otherwise it keeps running.  A thread in L3 always 
+//	gives it up.
+//----------------------------------------------------------------------
+
+bool
+MultiLevelPolicy::Preempts(Thread *next, Thread *current)
+{
+	if(current->getPriority() >= 100){
+		if(current->getBurstTime() >= next->getBurstTime()){
+			if (kernel->schedStats == NULL) {
+			cout << "Preempt (burst time)" << endl;
+			cout << "old : " << current->getBurstTime() << " on thread " << current->getID()  << endl;
+			cout << "new : " << next->getBurstTime() << " on thread " <<  next->getID() <<endl;
+			}
+			current->Preempt();
+		}
+	}
+	else if(current->getPriority() >=50 ){
+		if(next->getPriority() >= current->getPriority()) {
+			if (kernel->schedStats == NULL) {
+			cout << "Preempt (priority)" << endl;
+			cout << "old : " << current->getPriority() << endl;
+			cout << "new : " << next->getPriority() << endl;
+			}
+			current->Preempt();
+		}
+	} 
+
+	if(current->getPriority() >= 50 && !current->isPreempted()){
+		RemoveFromQueue(current, 1);
+		kernel->scheduler->ReadyToRun(next);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Blocked
+// 	If the thread is in L1, guess its next CPU burst.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::Blocked(Thread *thread)
+{
+	if(thread->getPriority() >= 100){
+        thread->setPreBurst(thread->getBurstTime());
+        UpdateBurstTime(thread, kernel->stats->totalTicks);
+    }
 }
 
 // Following functions are added by Chanwei
 
 //----------------------------------------------------------------------
-// Scheduler::Aging
+// QueueLevel
+//  Return the ready queue for threads of priority "p": L1, L2 or L3.
+//----------------------------------------------------------------------
+
+static int
+QueueLevel(int p)
+{
+    if (p >= 100)
+        return 1;
+    if (p >= 50)
+        return 2;
+    return 3;
+}
+
+//----------------------------------------------------------------------
+// QueueOrder
+//  Compare two ready threads by where they are in the ready queues:
+//  L1 before L2 before L3, and within L1 and L2, in the order they 
+//  will run.  Threads in L3 compare equal, so that they stay in the 
+//  order they were found.
+//----------------------------------------------------------------------
+
+static int
+QueueOrder(Thread *a, Thread *b)
+{
+    int la = QueueLevel(a->getPriority()), lb = QueueLevel(b->getPriority());
+
+    if (la != lb)
+        return la < lb ? -1 : 1;
+    if (la == 1)
+        return SJF(a, b);
+    if (la == 2) {
+        if (a->getPriority() != b->getPriority())
+            return a->getPriority() > b->getPriority() ? -1 : 1;
+        return Priority_Job(a, b);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Age
 //  if the thread wait for more than 1500 ticks, increase priority with 10
+//
+//  A thread's readyTime is reset every time it ages, as well as when
+//  it becomes ready, so the ready threads are due to age in the order
+//  oldestReady..newestReady.  We only look at the ones that are due,
+//  so when nobody is, this costs the same however many threads are
+//  ready.
+//
+//  The threads that are due are aged in the order of the ready 
+//  queues, so the log comes out the same as if we had checked every
+//  thread in every queue.  They are sorted into that order on 
+//  dueToAge, which is empty again when we return, and kept for the
+//  next time.
 //----------------------------------------------------------------------  
 
 void
-Scheduler::Aging(List<Thread *> *list)
-{
-    ListIterator<Thread *> *iterator = new ListIterator<Thread *>(list);
-    for( ; !(iterator->IsDone()); iterator->Next()) {
-        int currentTime = kernel->stats->totalTicks;
-        Thread* t = iterator->Item();
-        if((currentTime - t->getReadyTime()) >= 1500){
-            int old = t->getPriority();
-            t->Aging(AGING);// priority increase 10
-            t->setReadyTime(currentTime); // reset time ticks.
-            cout << "Tick [" << currentTime << "] : Thread " << t->getID() << " changes its priority from "<< old << " to " << t->getPriority() << endl;
-			CheckAndMove(t, old);
+MultiLevelPolicy::Age()
+{
+    int currentTime = kernel->stats->totalTicks;
+    Thread *t;
+
+    if (oldestReady == NULL 
+		|| currentTime - oldestReady->getReadyTime() < AGING_TIME) {
+        return;		// nobody is due
+    }
+    for (t = oldestReady; t != NULL 
+		&& currentTime - t->getReadyTime() >= AGING_TIME; 
+		t = t->newerReady) {
+        dueToAge->Insert(t);
+    }
+    while (!dueToAge->IsEmpty()) {
+        t = dueToAge->RemoveFront();
+        int old = t->getPriority();
+        int level = QueueLevel(old);
+
+        StopWaiting(t);
+        if (level == 2)
+            PJ_ReadyList->Remove(t);	// while it's still at its old priority
+        t->Aging(AGING);// priority increase 10
+        t->setReadyTime(currentTime); // reset time ticks.
+        SCHED_TRACE("Thread " << t->getID() << " changes its priority from "<< old << " to " << t->getPriority());
+        if (QueueLevel(t->getPriority()) != level) {
+            if (level == 3)
+                RR_ReadyList->Remove(t);
+            SCHED_TRACE("Thread " << t->getID() << " is removed from queue L" << level);
+            Insert(t);
+        } 
+        else {
+            if (level == 2)
+                PJ_ReadyList->Insert(t);
+            StartWaiting(t);
         }
     }
 }
 
 //----------------------------------------------------------------------
-// Scheduler::InsertToQueue
+// MultiLevelPolicy::StartWaiting
+//  Put a thread that has just become ready, or just aged, at the end
+//  of the aging order -- it has the longest to wait until it ages.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::StartWaiting(Thread *t)
+{
+    t->olderReady = newestReady;
+    t->newerReady = NULL;
+    if (newestReady == NULL)
+        oldestReady = t;
+    else
+        newestReady->newerReady = t;
+    newestReady = t;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::StopWaiting
+//  Take a thread out of the aging order, because it is leaving the
+//  ready queues (or about to go back in at the end).
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::StopWaiting(Thread *t)
+{
+    if (t->olderReady == NULL)
+        oldestReady = t->newerReady;
+    else
+        t->olderReady->newerReady = t->newerReady;
+    if (t->newerReady == NULL)
+        newestReady = t->olderReady;
+    else
+        t->newerReady->olderReady = t->olderReady;
+    t->olderReady = t->newerReady = NULL;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::InsertToQueue
 //  insert process to queue
 //-----------------------------------------------------------------------
 
 void
-Scheduler::InsertToQueue(Thread* t, int level)
+MultiLevelPolicy::InsertToQueue(Thread* t, int level)
 {
-    int currentTime = kernel->stats->totalTicks;
     if(level == 1){
         SJF_ReadyList->Insert(t);
     } 
@@ -316,17 +1063,18 @@ Scheduler::InsertToQueue(Thread* t, int level)
         RR_ReadyList->Append(t);
 		// for Round Robin, just simply append thread to the end of the list
     }
-	cout << "Tick [" << currentTime << "] : Thread " << t->getID() << " is inserted into queue L" << level << endl;
+    StartWaiting(t);
+	SCHED_TRACE("Thread " << t->getID() << " is inserted into queue L" << level);
 }
 
 //----------------------------------------------------------------------
-// Scheduler::RemoveFromQueue
+// MultiLevelPolicy::RemoveFromQueue
 // Remove process from queue
 //----------------------------------------------------------------------
 void
-Scheduler::RemoveFromQueue(Thread* t, int level)
+MultiLevelPolicy::RemoveFromQueue(Thread* t, int level)
 {
-    int currentTime = kernel->stats->totalTicks;
+    StopWaiting(t);
     if(level == 1){
         SJF_ReadyList->Remove(t);
     } 
@@ -336,25 +1084,11 @@ Scheduler::RemoveFromQueue(Thread* t, int level)
 	else if(level == 3){
         RR_ReadyList->Remove(t);
     }
-	cout << "Tick [" << currentTime << "] : Thread " << t->getID() << " is removed from queue L" << level << endl;
-}
-
-void
-Scheduler::CheckAndMove(Thread* t, int oldPriority)
-{
-    int p = t->getPriority();
-    if(oldPriority < 50 && p >= 50){
-        RemoveFromQueue(t, 3);
-		ReadyToRun(t);
-    } 
-	else if(oldPriority < 100 && p >= 100){
-        RemoveFromQueue(t, 2);
-		ReadyToRun(t);
-    } 
+	SCHED_TRACE("Thread " << t->getID() << " is removed from queue L" << level);
 }
 
 void
-Scheduler::UpdateBurstTime(Thread *t, int currentTime)
+MultiLevelPolicy::UpdateBurstTime(Thread *t, int currentTime)
 {
 	int preBurst = t->getPreBurst();
     int executionTime = currentTime - t->getStartTime() ;
@@ -362,7 +1096,7 @@ Scheduler::UpdateBurstTime(Thread *t, int currentTime)
 	
     t->setBurstTime(newBurst);
     t->resetLastBurst();
-	cout << "Tick [" << currentTime << "] : Thread " << t->getID() << " has nextBurst : " << t->getBurstTime() << endl;
+	SCHED_TRACE("Thread " << t->getID() << " has nextBurst : " << t->getBurstTime());
 }
 
 void
@@ -376,3 +1110,145 @@ SchedulerIntHandler::Schedule(int time)
 {
     kernel->interrupt->Schedule(this, time, SwitchInt);
 }
+
+//----------------------------------------------------------------------
+// PriorityArray::PriorityArray
+// 	Initialize an empty priority array.
+//
+//	"lowest", "highest" -- the range of priorities of the threads
+//		to be put in the array
+//----------------------------------------------------------------------
+
+PriorityArray::PriorityArray(int lowest, int highest)
+{
+    int numLists = highest - lowest + 1;
+
+    ASSERT(numLists > 0);
+    lowestPriority = lowest;
+    highestPriority = highest;
+    first = new Thread *[numLists];
+    last = new Thread *[numLists];
+    for (int i = 0; i < numLists; i++) {
+	first[i] = last[i] = NULL;
+    }
+    numWords = divRoundUp(numLists, BitsInWord);
+    occupied = new unsigned int[numWords];
+    for (int i = 0; i < numWords; i++) {
+	occupied[i] = 0;
+    }
+    numInArray = 0;
+}
+
+//----------------------------------------------------------------------
+// PriorityArray::~PriorityArray
+// 	De-allocate the array.  The threads in it are not deleted.
+//----------------------------------------------------------------------
+
+PriorityArray::~PriorityArray()
+{
+    delete [] first;
+    delete [] last;
+    delete [] occupied;
+}
+
+//----------------------------------------------------------------------
+// PriorityArray::Insert
+// 	Put a thread on the list for its priority, after the threads
+//	with lower IDs, and mark that list as not empty.
+//----------------------------------------------------------------------
+
+void
+PriorityArray::Insert(Thread *thread)
+{
+    int i = highestPriority - thread->getPriority();
+    Thread *before = last[i];
+
+    ASSERT(i >= 0 && i <= highestPriority - lowestPriority);
+    while (before != NULL && before->getID() > thread->getID()) {
+	before = before->prevInArray;
+    }
+    thread->prevInArray = before;
+    if (before == NULL) {		// goes at the front
+	thread->nextInArray = first[i];
+	first[i] = thread;
+    } else {
+	thread->nextInArray = before->nextInArray;
+	before->nextInArray = thread;
+    }
+    if (thread->nextInArray == NULL) {
+	last[i] = thread;
+    } else {
+	thread->nextInArray->prevInArray = thread;
+    }
+    occupied[i / BitsInWord] |= 1 << (i % BitsInWord);
+    numInArray++;
+}
+
+//----------------------------------------------------------------------
+// PriorityArray::Remove
+// 	Take a thread off the list for its priority, and if the list
+//	is now empty, say so in the bitmap.
+//----------------------------------------------------------------------
+
+void
+PriorityArray::Remove(Thread *thread)
+{
+    int i = highestPriority - thread->getPriority();
+
+    ASSERT(i >= 0 && i <= highestPriority - lowestPriority);
+    if (thread->prevInArray == NULL) {
+	ASSERT(first[i] == thread);
+	first[i] = thread->nextInArray;
+    } else {
+	thread->prevInArray->nextInArray = thread->nextInArray;
+    }
+    if (thread->nextInArray == NULL) {
+	ASSERT(last[i] == thread);
+	last[i] = thread->prevInArray;
+    } else {
+	thread->nextInArray->prevInArray = thread->prevInArray;
+    }
+    thread->prevInArray = thread->nextInArray = NULL;
+    if (first[i] == NULL) {
+	occupied[i / BitsInWord] &= ~(1 << (i % BitsInWord));
+    }
+    numInArray--;
+}
+
+//----------------------------------------------------------------------
+// PriorityArray::FirstOccupied
+// 	Return the index of the highest priority list with any threads
+//	on it, or -1 if the array is empty.  Only looks at the bitmap.
+//----------------------------------------------------------------------
+
+int
+PriorityArray::FirstOccupied()
+{
+    for (int w = 0; w < numWords; w++) {
+	if (occupied[w] != 0) {
+	    return w * BitsInWord + ffs(occupied[w]) - 1;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// PriorityArray::RemoveFront
+// 	Take the highest priority thread (of those, the one with the
+//	lowest ID) out of the array, and return it.  Return NULL if
+//	the array is empty.
+//----------------------------------------------------------------------
+
+Thread *
+PriorityArray::RemoveFront()
+{
+    int i = FirstOccupied();
+    Thread *thread;
+
+    if (i < 0) {
+	return NULL;
+    }
+    thread = first[i];
+    Remove(thread);
+    return thread;
+}
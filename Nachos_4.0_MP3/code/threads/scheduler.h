@@ -13,6 +13,8 @@
 #include "list.h"
 #include "thread.h"
 #include "callback.h"
+#include "schedpolicy.h"
+#include "hostcpu.h"
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
@@ -24,45 +26,204 @@ class SchedulerIntHandler : public CallBackObj {
     void Schedule(int time);
 };
 
+// The following class defines a "priority array" -- a ready queue 
+// for threads with priorities in a fixed range, with one list of
+// threads for each priority, and a bitmap of which lists are not
+// empty.  The highest priority thread can be found by looking for 
+// the first bit set, so the cost of Insert, Remove and RemoveFront
+// doesn't grow with the number of threads at other priorities.
+//
+// The lists are linked through the threads themselves (see 
+// Thread::prevInArray), so nothing is allocated, and Remove and
+// RemoveFront take constant time.
+//
+// Threads with the same priority come out lowest ID first.  Insert
+// finds a thread's place by walking back from the end of its list,
+// past the threads of the same priority with higher IDs; a thread 
+// forked after all of them (the usual case) goes straight on the end.
+//
+// A thread's priority must not change while it is in the array: 
+// Remove it first, and Insert it again afterwards.
+
+class PriorityArray {
+  public:
+    PriorityArray(int lowest, int highest);
+				// initialize an empty array, for threads
+				// with priorities "lowest" to "highest"
+    ~PriorityArray();		// de-allocate the array
+
+    void Insert(Thread *thread);// put a thread in the array
+    void Remove(Thread *thread);// take a thread out of the array
+    Thread *RemoveFront();	// take out the highest priority thread
+
+    bool IsEmpty() { return (numInArray == 0); }
+    int NumInArray() { return numInArray; }
+
+  private:
+    int lowestPriority, highestPriority;
+    Thread **first;		// first[i], last[i]: ends of the list of
+    Thread **last;		// threads with priority highestPriority 
+				// - i, by ID
+    unsigned int *occupied;	// bit i set if threads[i] isn't empty
+    int numWords;		// words in "occupied"
+    int numInArray;		// number of threads in the array
+
+    int FirstOccupied();	// index of the first non-empty list,
+				// -1 if none
+};
+
+// The following class defines MP3's scheduling policy, the default: 
+// three ready queues, by priority.  L1 (priority 100-149) runs the 
+// shortest guessed burst first, and preempts; L2 (50-99) runs the
+// highest priority first; L3 (0-49) is round robin.  A thread that 
+// has waited 1500 ticks gets 10 more priority (see Age).
+//
+// L2 is a PriorityArray, and L3 a list, so putting a thread on them
+// and taking the next one off take constant time.  L1 is ordered by 
+// the guessed burst -- a double, with no fixed range that could be
+// split into buckets the way priorities are -- so it is a red-black
+// tree instead, and takes O(log n) time.
+
+class MultiLevelPolicy : public SchedulingPolicy {
+  public:
+    MultiLevelPolicy();		// Initialize the ready queues
+    ~MultiLevelPolicy();	// De-allocate the ready queues
+
+    void Insert(Thread *thread);
+    Thread *RemoveNext();
+    int NumReady();
+    void Print();
+
+    int NumLevels() { return 3; }
+    int NumReadyAt(int level);
+
+    bool Preempts(Thread *next, Thread *current);
+    void Blocked(Thread *thread);
+
+	// Chanwei add
+	void UpdateBurstTime(Thread *t, int currentTime);
+	void Age();		// aging mechanism
+	// end Chanwei add
+	void RemoveFromQueue(Thread* t, int level);    
+
+  private:
+	// Chanwei add
+	void InsertToQueue(Thread* t, int level);
+    //void RemoveFromQueue(Thread* t, int level);
+    Thread *oldestReady;	// ready threads, in the order they 
+    Thread *newestReady;	// will be due to age
+    void StartWaiting(Thread *t);	// t is due to age last
+    void StopWaiting(Thread *t);	// t is no longer due to age
+    SortedList<Thread *> *dueToAge;	// the threads Age is aging, in
+					// queue order; empty otherwise
+    RBTree<Thread *> *SJF_ReadyList;	// ready list for SJF
+    PriorityArray *PJ_ReadyList;	// ready list for priority 
+    List<Thread *> *RR_ReadyList;		// ready list for Round robin
+	// end Chanwei add
+};
+
+// The following class defines one CPU of a simulated multiprocessor
+// (see -ncpu): the thread running on it, and its own ready queue.
+// A CPU's user registers are those of its thread -- in the machine
+// while the CPU is being simulated, and saved in the thread (see 
+// Thread::SaveUserState) while it isn't.
+//
+// With -parallel, a CPU also has a host thread, which runs its user
+// code while the kernel isn't simulating it (see Scheduler::RunAhead).
+
+class CPU {
+  public:
+    CPU(int cpuID, SchedulingPolicy *readyQueue) 
+	{ id = cpuID; thread = NULL; policy = readyQueue;
+	  userPaused = FALSE; host = NULL; }
+    ~CPU() { delete policy; delete host; }
+
+    int id;			// which CPU this is, from 0
+    Thread *thread;		// the thread running on it; NULL if idle
+    SchedulingPolicy *policy;	// the threads ready to run on it
+    bool userPaused;		// was the CPU paused between two of its
+				// thread's user instructions?
+    HostCPU *host;		// the host thread running it, or NULL
+};
+
 class Scheduler {
   public:
-    Scheduler();		// Initialize list of ready threads 
+    Scheduler(SchedPolicyType type, int quantum, int numCPUs);
+				// Initialize list of ready threads, 
+				// kept by the given policy ("quantum"
+				// is the time slice, for RR and MLFQ),
+				// one for each CPU
     ~Scheduler();		// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	
     				// Thread can be dispatched.
     Thread* FindNextToRun();	// Dequeue first thread on the ready 
 				// list, if any, and return thread.
+    int NumReady();		// How many threads are ready to run?
+    int NumLevels();		// How many ready queues are there?
+    int NumReadyAt(int level);	// How many threads are in queue level?
     void Run(Thread* nextThread, bool finishing);
     				// Cause nextThread to start running
     void CheckToBeDestroyed();// Check if thread that had been
     				// running needs to be deleted
     void Print();		// Print contents of ready list
+
+    bool TimeSliceOver();	// Should the current thread yield at
+				// this timer interrupt?
+    bool Preempts(Thread *next, Thread *current);
+				// Should next replace current, which
+				// has yielded?
+    void Blocked(Thread *thread);
+				// Thread is about to go to sleep
+    bool Admit(Thread *thread, int period, int deadline, int budget);
+				// Make thread a real-time task, if
+				// its deadlines can be met
+
+    int NumCPUs() { return numCPUs; }
+    int NumRunningElsewhere();	// How many other CPUs are busy?
+    void EndTurn() { endingTurn = TRUE; }
+				// At the next Yield, only let another
+				// CPU run; the thread keeps its own
+    bool EndingTurn();		// Was EndTurn called?  (Resets it)
+    void SwitchCPU();		// Simulate the CPU that is furthest
+				// behind, if it isn't the current one
+    void RunInParallel(int window);
+				// Run the CPUs' user code on host threads,
+				// up to "window" ticks ahead
     
     // SelfTest for scheduler is implemented in class Thread
 
 	// Chanwei add
-	void CheckAndMove(Thread* t, int oldPriority);
-	void UpdateBurstTime(Thread *t, int currentTime);
-	void Aging(List<Thread *> *list);	// aging mechanism
     void CallBack();
 	// end Chanwei add
-	void RemoveFromQueue(Thread* t, int level);    
 
   private:
-    List<Thread *> *readyList;  // queue of threads that are ready to run,
-				// but not running
+    CPU **cpus;			// the CPUs, each with its ready threads,
+				// and the rules for which of them runs next
+    int numCPUs;
+    CPU *currentCPU;		// the CPU being simulated, which
+				// kernel->currentThread is running on
+    bool endingTurn;		// set by EndTurn
+    int parallelTicks;		// how far RunAhead may run; 0 if the
+				// CPUs have no host threads
+    int quantum;		// the time slice, which caps parallelTicks
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     				// by the next thread that runs
 
 	// Chanwei add
-	void InsertToQueue(Thread* t, int level);
-    //void RemoveFromQueue(Thread* t, int level);
 	SchedulerIntHandler* intHandler;
-    SortedList<Thread *> *SJF_ReadyList;// ready list for SJF
-    SortedList<Thread *> *PJ_ReadyList;	// ready list for priority 
-    List<Thread *> *RR_ReadyList;		// ready list for Round robin
 	// end Chanwei add
+
+    void Account(CPU *cpu, Thread *oldThread, Thread *nextThread);
+				// oldThread gives cpu to nextThread;
+				// either may be NULL, if cpu is idle
+    Thread *Steal(CPU *thief);	// take a ready thread from another CPU
+    Thread *NextCPU();		// pick the CPU to simulate next, and
+				// return its thread
+    void RunAhead();		// run the paused CPUs' user code on their
+				// host threads, all at once
+    void Dispatch(Thread *oldThread, Thread *nextThread);
+				// switch the machine to nextThread
 };
 
 #endif // SCHEDULER_H
@@ -36,6 +36,8 @@
 #include "synch.h"
 #include "main.h"
 
+Slab Semaphore::slab("semaphore");
+
 //----------------------------------------------------------------------
 // Semaphore::Semaphore
 // 	Initialize a semaphore, so that it can be used for synchronization.
@@ -135,7 +137,7 @@ SelfTestHelper (Semaphore *pong)
 void
 Semaphore::SelfTest()
 {
-    Thread *helper = new Thread("ping", 1);
+    Thread *helper = new Thread("ping", 1, SmallStack);
 
     ASSERT(value == 0);		// otherwise test won't work!
     ping = new Semaphore("ping", 0);
@@ -233,7 +235,8 @@ Condition::~Condition()
 //	allocating a semaphore for each waiting thread.  The signaller
 //	will V() this semaphore, so there is no chance the waiter
 //	will miss the signal, even though the lock is released before
-//	calling P().
+//	calling P().  The semaphore (and its queue) come from slabs, so
+//	this doesn't go to the host's allocator on every wait.
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	waiter must re-acquire the monitor lock when waking up.
@@ -46,6 +46,11 @@ class Semaphore {
     void P();	 	// these are the only operations on a semaphore
     void V();	 	// they are both *atomic*
     void SelfTest();	// test routine for semaphore implementation
+
+    void *operator new(size_t size) { return slab.Alloc(size); }
+    void operator delete(void *p, size_t size) { slab.Free(p, size); }
+    static Slab slab;	// where semaphores are allocated (one for each
+			// Condition::Wait)
     
   private:
     char* name;        // useful for debugging
@@ -117,7 +117,7 @@ template <class T>
 void
 SynchList<T>::SelfTest(T val)
 {
-    Thread *helper = new Thread("ping", 1);
+    Thread *helper = new Thread("ping", 1, SmallStack);
     
     ASSERT(list->IsEmpty());
     selfTestPing = new SynchList<T>;
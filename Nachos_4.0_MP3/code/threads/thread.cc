@@ -20,6 +20,7 @@
 #include "thread.h"
 #include "switch.h"
 #include "synch.h"
+#include "schedstats.h"
 #include "sysdep.h"
 
 // this is put at the top of the execution stack, for detecting stack overflows
@@ -31,9 +32,10 @@ const int STACK_FENCEPOST = 0xdedbeef;
 //	Thread::Fork.
 //
 //	"threadName" is an arbitrary string, useful for debugging.
+//	"stackWords" is the size of its stack, in words
 //----------------------------------------------------------------------
 
-Thread::Thread(char* threadName, int threadID)
+Thread::Thread(char* threadName, int threadID, ThreadStackSize stackWords)
 {
 	priority = 151;	// initial the priority
 	preempted = 0;	// initial preemptive
@@ -42,6 +44,7 @@ Thread::Thread(char* threadName, int threadID)
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = stackWords;
     status = JUST_CREATED;
     for (int i = 0; i < MachineStateSize; i++) {
 		machineState[i] = NULL;		
@@ -50,11 +53,21 @@ Thread::Thread(char* threadName, int threadID)
 					// of machine registers
     }
     space = NULL;
+    olderReady = newerReady = NULL;
+    prevInArray = nextInArray = NULL;
+    schedLevel = 0;
+    schedPass = 0;
+    vruntime = 0;
+    vruntimeTicks = 0;
+    edf = NULL;
+    schedStats = NULL;
+    cpu = -1;
 }
 
 // Chanwei add
 // Thread defined by Chanwei
-Thread::Thread(char* threadName, int threadID, int prior)
+Thread::Thread(char* threadName, int threadID, int prior,
+	       ThreadStackSize stackWords)
 {
     priority = prior;
     preempted = 0;
@@ -65,6 +78,7 @@ Thread::Thread(char* threadName, int threadID, int prior)
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = stackWords;
     status = JUST_CREATED;
     for (int i = 0; i < MachineStateSize; i++) {
     	machineState[i] = NULL;     
@@ -73,6 +87,15 @@ Thread::Thread(char* threadName, int threadID, int prior)
                     // of machine registers
     }
     space = NULL;
+    olderReady = newerReady = NULL;
+    prevInArray = nextInArray = NULL;
+    schedLevel = 0;
+    schedPass = 0;
+    vruntime = 0;
+    vruntimeTicks = 0;
+    edf = NULL;
+    schedStats = NULL;
+    cpu = -1;
 }
 // end Chanwei add
 
@@ -94,7 +117,7 @@ Thread::~Thread()
     DEBUG(dbgThread, "Deleting thread: " << name);
     ASSERT(this != kernel->currentThread);
     if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+	kernel->stackPool->Free((char *) stack, stackSize * sizeof(int));
 }
 
 //----------------------------------------------------------------------
@@ -124,7 +147,7 @@ Thread::Fork(VoidFunctionPtr func, void *arg)
     Scheduler *scheduler = kernel->scheduler;
     IntStatus oldLevel;
     
-    DEBUG(dbgThread, "Forking thread: " << name << " f(a): " << (int) func << " " << arg);
+    DEBUG(dbgThread, "Forking thread: " << name << " f(a): " << (void *) func << " " << arg);
     StackAllocate(func, arg);
 
     oldLevel = interrupt->SetLevel(IntOff);
@@ -153,7 +176,7 @@ Thread::CheckOverflow()
 {
     if (stack != NULL) {
 #ifdef HPUX			// Stacks grow upward on the Snakes
-	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
+	ASSERT(stack[stackSize - 1] == STACK_FENCEPOST);
 #else
 	ASSERT(*stack == STACK_FENCEPOST);
 #endif
@@ -224,6 +247,11 @@ Thread::Finish ()
 //	original state, in case we are called with interrupts disabled. 
 //
 // 	Similar to Thread::Sleep(), but a little different.
+//
+//	NOTE: on a multiprocessor (-ncpu), this is also where the machine
+//	switches to simulating another CPU, at each timer interrupt (see
+//	Scheduler::SwitchCPU); if the time slice isn't over, the thread
+//	keeps its own CPU, and only waits for it to be simulated again.
 //----------------------------------------------------------------------
 
 void
@@ -236,40 +264,32 @@ Thread::Yield ()
     
     DEBUG(dbgThread, "Yielding thread: " << name);
 
+    if (kernel->scheduler->EndingTurn()) {
+	kernel->scheduler->SwitchCPU();	// keep this CPU, but let another
+					// CPU catch up
+	(void) kernel->interrupt->SetLevel(oldLevel);
+	return;
+    }
+
 	kernel->scheduler->ReadyToRun(this);
     nextThread = kernel->scheduler->FindNextToRun();
 
 	if (nextThread != NULL){
-		if(nextThread->getID() != this->getID()){
-			if(this->getPriority() >= 100){
-         		if(this->getBurstTime() >= nextThread->getBurstTime()){
-             		cout << "Preempt (burst time)" << endl;
-             		cout << "old : " << this->getBurstTime() << " on thread " << this->getID()  << endl;
-             		cout << "new : " << nextThread->getBurstTime() << " on thread " <<  nextThread->getID() <<endl;
-             		this->Preempt();
-         		}
-    		}
-			else if(this->getPriority() >=50 ){
-				if(nextThread->getPriority() >= this->getPriority()) {
-             		cout << "Preempt (priority)" << endl;
-             		cout << "old : " << this->getPriority() << endl;
-             		cout << "new : " << nextThread->getPriority() << endl;
-             		this->Preempt();
-         		}
-			} 
-
-			if(this->priority >= 50 && !this-> preempted){
-				kernel->scheduler->RemoveFromQueue(this, 1);
-                kernel->scheduler->ReadyToRun(nextThread);
-			}
-			else{
+		if(nextThread != this){
+			if(kernel->scheduler->Preempts(nextThread, this)){
 				this->resetPreempt();
 				kernel->scheduler->Run(nextThread, FALSE);
+				(void) kernel->interrupt->SetLevel(oldLevel);
+				return;
 			}
 		}
-		else
+		else if (kernel->schedStats == NULL)
 			cout << name << " will keep running" << endl;
     }
+    status = RUNNING;			// ReadyToRun made us READY, but
+					// we're keeping the CPU after all
+    kernel->scheduler->SwitchCPU();	// on a multiprocessor, let another
+					// CPU catch up
     (void) kernel->interrupt->SetLevel(oldLevel);
 }
 
@@ -285,7 +305,8 @@ Thread::Yield ()
 //	we have no thread to run.  "Interrupt::Idle" is called
 //	to signify that we should idle the CPU until the next I/O interrupt
 //	occurs (the only thing that could cause a thread to become
-//	ready to run).
+//	ready to run).  On a multiprocessor, that's only if the other CPUs
+//	are idle too; otherwise this CPU goes idle, and another one runs.
 //
 //	NOTE: we assume interrupts are already disabled, because it
 //	is called from the synchronization routines which must
@@ -306,21 +327,20 @@ Thread::Sleep (bool finishing)
 
     status = BLOCKED;
 	//cout << "debug Thread::Sleep " << name << "wait for Idle\n";
-	cout << "Tick [" << currentTime << "] : Thread " << ID << " sleep" << endl;
+	SCHED_TRACE("Thread " << ID << " sleep");
 
 	this->setSleep();		//if sleep, calculate execution time at sleep time.
 	this->setExecutionTime(currentTime - this->getStartTime());
 
-	if(this->getPriority() >= 100){
-        this->setPreBurst(this->getBurstTime());
-        kernel->scheduler->UpdateBurstTime(this, kernel->stats->totalTicks);
-    }
+	kernel->scheduler->Blocked(this);
 	kernel->interrupt->SliceForward();
-    while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL) {
+    while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL
+		&& kernel->scheduler->NumRunningElsewhere() == 0) {
 		kernel->interrupt->Idle();	
 		// no one to run, wait for an interrupt
 	}    
-    // returns when it's time for us to run
+    // returns when it's time for us to run; if nextThread is NULL,
+    // this CPU goes idle, and another one runs
     kernel->scheduler->Run(nextThread, finishing); 
 }
 
@@ -375,34 +395,34 @@ PLabelToAddr(void *plabel)
 void
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = (int *) kernel->stackPool->Alloc(stackSize * sizeof(int));
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
     // everyone else works the other way: from high addresses to low addresses
     stackTop = stack + 16;	// HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    stack[stackSize - 1] = STACK_FENCEPOST;
 #endif
 
 #ifdef SPARC
-    stackTop = stack + StackSize - 96; 	// SPARC stack must contains at 
+    stackTop = stack + stackSize - 96; 	// SPARC stack must contains at 
 					// least 1 activation record 
 					// to start with.
     *stack = STACK_FENCEPOST;
 #endif 
 
 #ifdef PowerPC // RS6000
-    stackTop = stack + StackSize - 16; 	// RS6000 requires 64-byte frame marker
+    stackTop = stack + stackSize - 16; 	// RS6000 requires 64-byte frame marker
     *stack = STACK_FENCEPOST;
 #endif 
 
 #ifdef DECMIPS
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
     *stack = STACK_FENCEPOST;
 #endif
 
 #ifdef ALPHA
-    stackTop = stack + StackSize - 8;	// -8 to be on the safe side!
+    stackTop = stack + stackSize - 8;	// -8 to be on the safe side!
     *stack = STACK_FENCEPOST;
 #endif
 
@@ -411,10 +431,20 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
     // the x86 passes the return address on the stack.  In order for SWITCH() 
     // to go to ThreadRoot when we switch to this thread, the return addres 
     // used in SWITCH() must be the starting address of ThreadRoot.
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
     *(--stackTop) = (int) ThreadRoot;
     *stack = STACK_FENCEPOST;
 #endif
+
+#ifdef x86_64
+    // as on the x86, SWITCH() returns to the address on top of the stack,
+    // which must be ThreadRoot.  That address is 8 bytes, not an int, and
+    // the x86-64 wants the stack 16-byte aligned where ThreadRoot is
+    // "called", so align the slot that holds it.
+    stackTop = (int *) ((unsigned long) (stack + stackSize - 8) & ~15UL);
+    *(void **) stackTop = (void *) ThreadRoot;
+    *stack = STACK_FENCEPOST;
+#endif
     
 #ifdef PARISC
     machineState[PCState] = PLabelToAddr(ThreadRoot);
@@ -440,13 +470,22 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
 //	while executing kernel code.  This routine saves the former.
+//
+//	The registers are those of the machine the kernel runs on, unless
+//	"machine" says otherwise.
 //----------------------------------------------------------------------
 
 void
 Thread::SaveUserState()
+{
+    SaveUserState(kernel->machine);
+}
+
+void
+Thread::SaveUserState(Machine *machine)
 {
     for (int i = 0; i < NumTotalRegs; i++)
-	userRegisters[i] = kernel->machine->ReadRegister(i);
+	userRegisters[i] = machine->ReadRegister(i);
 }
 
 //----------------------------------------------------------------------
@@ -456,13 +495,22 @@ Thread::SaveUserState()
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
 //	while executing kernel code.  This routine restores the former.
+//
+//	The registers are those of the machine the kernel runs on, unless
+//	"machine" says otherwise.
 //----------------------------------------------------------------------
 
 void
 Thread::RestoreUserState()
+{
+    RestoreUserState(kernel->machine);
+}
+
+void
+Thread::RestoreUserState(Machine *machine)
 {
     for (int i = 0; i < NumTotalRegs; i++)
-	kernel->machine->WriteRegister(i, userRegisters[i]);
+	machine->WriteRegister(i, userRegisters[i]);
 }
 
 
@@ -497,7 +545,7 @@ Thread::SelfTest()
 {
     DEBUG(dbgThread, "Entering Thread::SelfTest");
 
-    Thread *t = new Thread("forked thread", 1);
+    Thread *t = new Thread("forked thread", 1, SmallStack);
 
     t->Fork((VoidFunctionPtr) SimpleThread, (void *) 1);
     kernel->currentThread->Yield();
@@ -24,7 +24,8 @@
 //	that your thread stacks are too small.)
 //	
 //	One thing to try if you find yourself with seg faults is to
-//	increase the size of thread stack -- ThreadStackSize.
+//	increase the size of thread stack -- StackSize, or the size the
+//	thread asked for when it was created (see ThreadStackSize).
 //
 //  	In this interface, forking a thread takes two steps.
 //	We must first allocate a data structure for it: "t = new Thread".
@@ -57,10 +58,21 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = (8 * 1024);	// in words
 
+// A thread that needs much less stack than that can say so when it is
+// created.  The sizes are in words.
+enum ThreadStackSize {
+    SmallStack = (2 * 1024),		// helper threads that only do a
+					// little, like the self tests'
+    DefaultStack = StackSize
+};
+
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, ZOMBIE };
 
+class EDFTask;				// see schedpolicy.h
+class ThreadSchedStats;			// see schedstats.h
+
 
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
@@ -81,10 +93,14 @@ class Thread {
     void *machineState[MachineStateSize];  // all registers except for stackTop
 
   public:
-    Thread(char* debugName, int threadID);		// initialize a Thread 
+    Thread(char* debugName, int threadID,
+	   ThreadStackSize stackWords = DefaultStack);
+					// initialize a Thread, with a
+					// stack of "stackWords" words
     
 	// Chanwei add
-    Thread(char* debugName, int threadID, int prior);
+    Thread(char* debugName, int threadID, int prior,
+	   ThreadStackSize stackWords = DefaultStack);
     // initialize a thread
 	// end Chanwei add
 	
@@ -196,6 +212,7 @@ class Thread {
     int *stack; 	 	// Bottom of the stack 
 				// NULL if this is the main thread
 				// (If NULL, don't deallocate stack)
+    int stackSize;		// size of the stack, in words
     ThreadStatus status;	// ready, running or blocked
     char* name;
 	int   ID;
@@ -226,8 +243,31 @@ class Thread {
 	
     void SaveUserState();		// save user-level register state
     void RestoreUserState();		// restore user-level register state
+    void SaveUserState(Machine *machine);
+    void RestoreUserState(Machine *machine);
+					// same, from or to another CPU's
+					// registers (see Scheduler::RunAhead)
 
     AddrSpace *space;			// User code this thread is running.
+
+    Thread *olderReady;			// While READY, the threads that
+    Thread *newerReady;			// have waited longer and less long
+					// since they last aged (see 
+					// MultiLevelPolicy::Age)
+    Thread *prevInArray;		// While in a PriorityArray, the
+    Thread *nextInArray;		// threads before and after it on
+					// the list for its priority
+    int schedLevel;			// MLFQ queue the thread is in
+    unsigned int schedPass;		// pass, for stride scheduling
+    unsigned int vruntime;		// virtual runtime, for CFS
+    int vruntimeTicks;			// totalTicks when vruntime was
+					// last brought up to date
+    EDFTask *edf;			// period, deadline and budget, for
+					// EDF; NULL if not a real-time task
+    ThreadSchedStats *schedStats;	// counters for -schedstats; NULL if
+					// not recorded yet
+    int cpu;				// CPU whose ready list it goes on
+					// (see -ncpu); -1 if none yet
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
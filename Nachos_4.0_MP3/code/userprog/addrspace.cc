@@ -22,6 +22,7 @@
 #include "noff.h"
 
 bool AddrSpace::usedPhyPage[NumPhysPages] = {0};	// initialize pPageTable used state
+bool AddrSpace::usedASID[NumASIDs] = {0};
 //----------------------------------------------------------------------
 // SwapHeader
 // 	Do little endian to big endian conversion on the bytes in the 
@@ -64,10 +65,22 @@ SwapHeader (NoffHeader *noffH)
 //	Set up the translation from program memory to physical 
 //	memory.  For now, this is really simple (1:1), since we are
 //	only uniprogramming, and we have a single unsegmented page table
+//
+//	With a TLB, also pick an address space identifier, to tell our
+//	TLB entries apart from those of other address spaces.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace()
 {
+#ifdef USE_TLB
+    for (asid = 0; asid < NumASIDs && usedASID[asid]; asid++)
+	;
+    ASSERT(asid < NumASIDs);		// too many address spaces at once
+    usedASID[asid] = TRUE;
+#else
+    asid = 0;
+#endif
+    programName = NULL;
     /*pageTable = new TranslationEntry[NumPhysPages];
     for (int i = 0; i < NumPhysPages; i++) {
 		pageTable[i].virtualPage = i;	// for now, virt page # = phys page #
@@ -86,6 +99,9 @@ AddrSpace::AddrSpace()
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
 // 	Dealloate an address space.
+//
+//	With a TLB, drop our entries from it before our identifier
+//	can be given to another address space.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
@@ -94,7 +110,15 @@ AddrSpace::~AddrSpace()
 	for(i=0; i < numPages; i++){
     	usedPhyPage[pageTable[i].physicalPage]=FALSE;
     }
+#ifdef USE_TLB
+    for (i = 0; i < kernel->machine->tlbSize; i++) {
+	if (kernel->machine->tlb[i].asid == asid)
+	    kernel->machine->tlb[i].valid = FALSE;
+    }
+    usedASID[asid] = FALSE;
+#endif
     delete pageTable;
+    delete [] programName;
 }
 
 
@@ -119,6 +143,8 @@ AddrSpace::Load(char *fileName)
 	cerr << "Unable to open file " << fileName << "\n";
 	return FALSE;
     }
+    programName = new char[strlen(fileName) + 1];
+    strcpy(programName, fileName);
 
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
     if ((noffH.noffMagic != NOFFMAGIC) && 
@@ -155,6 +181,9 @@ AddrSpace::Load(char *fileName)
         pageTable[i].use = FALSE;
         pageTable[i].dirty = FALSE;
         pageTable[i].readOnly = FALSE;
+        pageTable[i].asid = asid;
+	kernel->machine->InvalidateCode(j * PageSize, PageSize);	// frame may hold
+						// a previous program's code
     }
 
 	size = numPages * PageSize;
@@ -278,13 +307,203 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table,
+//	and have it forget the translations it cached for the
+//	previous address space.
+//
+//	With a TLB, the machine never sees the page table; just tell
+//	it which TLB entries are ours.  The entries of the previous
+//	address space stay in the TLB, and are still there if it runs
+//	again soon.
+//
+//	The machine is the one the kernel runs on, unless "machine" says
+//	otherwise.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
-    kernel->machine->pageTable = pageTable;
-    kernel->machine->pageTableSize = numPages;
+    RestoreState(kernel->machine);
+}
+
+void AddrSpace::RestoreState(Machine *machine) 
+{
+#ifdef USE_TLB
+    machine->currentASID = asid;
+#else
+    machine->pageTable = pageTable;
+    machine->pageTableSize = numPages;
+#endif
+    machine->FlushSoftTLB();
+}
+
+//----------------------------------------------------------------------
+// ProfileSymbol
+// 	A function of a user program, as listed in its symbol file, and
+//	the number of instructions executed in it.
+//----------------------------------------------------------------------
+
+class ProfileSymbol {
+  public:
+    unsigned int address;	// where the function starts
+    char name[64];
+    int count;
+};
+
+//----------------------------------------------------------------------
+// ReadSymbols
+// 	Read the text (code) symbols of a user program from the file
+//	"symFile", as output by "nm -n" on its .coff file (see
+//	test/Makefile): one "address type name" line per symbol.
+//	Returns the number of symbols, sorted by address, in "*symbols";
+//	0 if there is no such file.
+//----------------------------------------------------------------------
+
+static int
+ReadSymbols(char *symFile, ProfileSymbol **symbols)
+{
+    OpenFile *file = kernel->fileSystem->Open(symFile);
+    int length, numSymbols;
+    char *text, *line;
+    ProfileSymbol *table;
+
+    if (file == NULL) {
+	*symbols = NULL;
+	return 0;
+    }
+    length = file->Length();
+    text = new char[length + 1];
+    length = file->ReadAt(text, length, 0);
+    text[length] = '\0';
+    delete file;
+
+    table = new ProfileSymbol[length / 4 + 1];	// lines are at least 4 chars
+    numSymbols = 0;
+    for (line = strtok(text, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+	ProfileSymbol *sym = &table[numSymbols];
+	char type;
+
+	if (sscanf(line, "%x %c %63s", &sym->address, &type, sym->name) == 3
+		&& (type == 'T' || type == 't')) {
+	    sym->count = 0;
+	    numSymbols++;
+	}
+    }
+    delete [] text;
+
+    // insertion sort by address, in case the file isn't already
+    for (int i = 1; i < numSymbols; i++) {
+	ProfileSymbol sym = table[i];
+	int j;
+
+	for (j = i; j > 0 && table[j - 1].address > sym.address; j--)
+	    table[j] = table[j - 1];
+	table[j] = sym;
+    }
+    *symbols = table;
+    return numSymbols;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PrintProfile
+// 	Print how many instructions the program executed in each of its
+//	functions, hottest first, from the counts the machine kept while
+//	profiling (see Machine::StartProfiling).  The function names come
+//	from the program's symbol file, "<program>.sym".  The counts for
+//	our pages are reset, so that the next program to use them starts
+//	from zero.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::PrintProfile()
+{
+    int *counts = kernel->machine->profileCounts;
+    char *symFile;
+    ProfileSymbol *symbols;
+    int numSymbols, total, unknown;
+    char buf[100];
+
+    if (counts == NULL || programName == NULL) {
+	return;				// not profiling
+    }
+    symFile = new char[strlen(programName) + 5];
+    sprintf(symFile, "%s.sym", programName);
+    numSymbols = ReadSymbols(symFile, &symbols);
+
+    total = unknown = 0;
+    for (unsigned int vpn = 0; vpn < numPages; vpn++) {
+	int frame = pageTable[vpn].physicalPage;
+
+	for (int word = 0; word < PageSize / 4; word++) {
+	    int *count = &counts[(frame * PageSize) / 4 + word];
+	    unsigned int address = vpn * PageSize + word * 4;
+	    int lo = 0, hi = numSymbols - 1;
+
+	    if (*count == 0)
+		continue;
+	    while (lo <= hi) {		// find the last symbol <= address
+		int mid = (lo + hi) / 2;
+
+		if (symbols[mid].address <= address)
+		    lo = mid + 1;
+		else
+		    hi = mid - 1;
+	    }
+	    if (hi >= 0)
+		symbols[hi].count += *count;
+	    else
+		unknown += *count;
+	    total += *count;
+	    *count = 0;
+	}
+    }
+
+    cout << "Profile of " << programName << ": " << total;
+    cout << " instructions\n";
+    if (numSymbols == 0) {
+	cout << "  (no symbols: " << symFile << " not found)\n";
+    }
+    for (;;) {				// print the hottest remaining
+	int hottest = -1;
+
+	for (int i = 0; i < numSymbols; i++)
+	    if (symbols[i].count > 0 &&
+		    (hottest < 0 || symbols[i].count > symbols[hottest].count))
+		hottest = i;
+	if (hottest < 0)
+	    break;
+	sprintf(buf, "  %10d %5.1f%%  %s\n", symbols[hottest].count,
+		(100.0 * symbols[hottest].count) / total, symbols[hottest].name);
+	cout << buf;
+	symbols[hottest].count = 0;
+    }
+    if (unknown > 0 && numSymbols > 0) {
+	sprintf(buf, "  %10d %5.1f%%  (before the first symbol)\n", unknown,
+		(100.0 * unknown) / total);
+	cout << buf;
+    }
+    delete [] symbols;
+    delete [] symFile;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::HandleTLBMiss
+// 	Called on a TLB miss (a PageFaultException, with USE_TLB) in this
+//	address space: load the page table entry for the virtual address
+//	_vaddr_ into the TLB, so that the instruction can be restarted.
+//	Return FALSE if the address is not part of the address space.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::HandleTLBMiss(unsigned int vaddr)
+{
+    unsigned int vpn = vaddr / PageSize;
+
+    if (vpn >= numPages || !pageTable[vpn].valid) {
+	return FALSE;
+    }
+    DEBUG(dbgAddr, "TLB miss at " << vaddr << ", asid " << asid);
+    kernel->machine->RefillTLB(&pageTable[vpn]);
+    return TRUE;
 }
 
 
@@ -16,6 +16,8 @@
 #include "copyright.h"
 #include "filesys.h"
 
+class Machine;
+
 #define UserStackSize		1024 	// increase this as necessary!
 
 class AddrSpace {
@@ -33,10 +35,20 @@ class AddrSpace {
 
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
+    void RestoreState(Machine *machine); // same, on another CPU
+
+    void PrintProfile();		// Print where the program spent its
+					// time, if profiling ("nachos -prof")
+
+    bool HandleTLBMiss(unsigned int vaddr);
+					// Load the translation for _vaddr_
+					// into the TLB; FALSE if illegal
 
 	// Chan-Wei
     static bool usedPhyPage[NumPhysPages];
 	// Used to record which page has been used
+    static bool usedASID[NumASIDs];
+	// Used to record which address space identifiers are in use
 
     // Translate virtual address _vaddr_
     // to physical address _paddr_. _mode_
@@ -48,6 +60,8 @@ class AddrSpace {
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int asid;				// Tags this space's TLB entries
+    char *programName;			// File the program was loaded from
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
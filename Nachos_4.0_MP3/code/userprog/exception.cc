@@ -75,6 +75,7 @@ ExceptionHandler(ExceptionType which)
       	}
 		case SC_Halt:{
 			DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
+			kernel->currentThread->space->PrintProfile();
 			SysHalt();
                         cout<<"in exception\n";
 			ASSERTNOTREACHED();
@@ -130,6 +131,7 @@ ExceptionHandler(ExceptionType which)
             OpenFileId id = kernel->machine->ReadRegister(6);
             {
             int read_in_char = SysRead(buffer,size,id);
+            kernel->machine->InvalidateCode(val, read_in_char);
             kernel->machine->WriteRegister(2,read_in_char);
             }
             kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
@@ -193,12 +195,31 @@ ExceptionHandler(ExceptionType which)
 			cout << "result is " << result << "\n";	
 			return;	
 			ASSERTNOTREACHED();
+            break;
+		}
+		case SC_SetDeadline:{
+			DEBUG(dbgSys, "SetDeadline " << kernel->machine->ReadRegister(4) << " " << kernel->machine->ReadRegister(5) << " " << kernel->machine->ReadRegister(6) << "\n");
+			status = SysSetDeadline((int)kernel->machine->ReadRegister(4),
+				(int)kernel->machine->ReadRegister(5),
+				(int)kernel->machine->ReadRegister(6));
+			kernel->machine->WriteRegister(2, (int) status);
+			kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+			return;
+			ASSERTNOTREACHED();
             break;
 		}
 		case SC_Exit:{
 			DEBUG(dbgAddr, "Program exit\n");
             		val=kernel->machine->ReadRegister(4);
             		cout << "return value:" << val << endl;
+			kernel->currentThread->space->PrintProfile();
+			if (debug->IsEnabled(dbgPerf)) {
+			    kernel->stats->PrintHostTime();
+			    Slab::PrintAll();
+			    kernel->stackPool->Print();
+			}
 			kernel->currentThread->Finish();
             		break;
       		default:
@@ -207,6 +228,14 @@ ExceptionHandler(ExceptionType which)
 		}
 		}
 		break;
+#ifdef USE_TLB
+	case PageFaultException:	// TLB miss: refill from the page table
+		val = kernel->machine->ReadRegister(BadVAddrReg);
+		if (kernel->currentThread->space->HandleTLBMiss(val))
+			return;		// and re-execute the instruction
+		cerr << "Illegal virtual address " << val << "\n";
+		break;
+#endif
 	default:
 		cerr << "Unexpected user mode exception " << (int)which << "\n";
 		break;
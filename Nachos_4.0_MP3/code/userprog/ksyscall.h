@@ -58,6 +58,15 @@ int SysRead(char *buffer, int size, OpenFileId id)
 	return kernel->interrupt->ReadFile(buffer,size,id);
 }
 
+int SysSetDeadline(int period, int deadline, int budget)
+{
+	// return value
+	// 1: admitted
+	// 0: not admitted
+	return kernel->scheduler->Admit(kernel->currentThread,
+					period, deadline, budget);
+}
+
 int SysClose(OpenFileId id){
     DEBUG(dbChanwei,"SysClose in ksyscall.h ok!");
 	return kernel->interrupt->CloseFile(id);
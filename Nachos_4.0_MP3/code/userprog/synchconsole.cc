@@ -15,11 +15,13 @@
 //
 //      "inputFile" -- if NULL, use stdin as console device
 //              otherwise, read from this file
+//      "hostWait" -- if TRUE, wait for keystrokes on the host when the
+//		machine has nothing else to do (see ConsoleInput)
 //----------------------------------------------------------------------
 
-SynchConsoleInput::SynchConsoleInput(char *inputFile)
+SynchConsoleInput::SynchConsoleInput(char *inputFile, bool hostWait)
 {
-    consoleInput = new ConsoleInput(inputFile, this);
+    consoleInput = new ConsoleInput(inputFile, this, hostWait);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
 }
@@ -47,6 +49,8 @@ SynchConsoleInput::GetChar()
     char ch;
 
     lock->Acquire();
+    consoleInput->StartPolling();	// the keyboard is only polled
+    					// while someone is waiting
     waitFor->P();	// wait for EOF or a char to be available.
     ch = consoleInput->GetChar();
     lock->Release();
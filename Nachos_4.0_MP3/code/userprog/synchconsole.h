@@ -22,7 +22,8 @@
 
 class SynchConsoleInput : public CallBackObj {
   public:
-    SynchConsoleInput(char *inputFile); // Initialize the console device
+    SynchConsoleInput(char *inputFile, bool hostWait);
+    					// Initialize the console device
     ~SynchConsoleInput();		// Deallocate console device
 
     char GetChar();		// Read a character, waiting if necessary
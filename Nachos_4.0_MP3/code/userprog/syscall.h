@@ -36,6 +36,7 @@
 #define SC_ThreadJoin   15
 #define SC_Add			42
 #define SC_PrintInt		16
+#define SC_SetDeadline	17
 #define SC_MSG			100
 
 #ifndef IN_ASM
@@ -180,6 +181,15 @@ int ThreadJoin(ThreadId id);
  */
 void ThreadExit(int ExitCode);	
 
+/*
+ * Make the current thread a real-time task: every "period" ticks, it
+ * needs up to "budget" ticks of CPU, within "deadline" ticks.  Only
+ * the EDF scheduler (nachos -sched edf) admits real-time tasks, and
+ * only if it can still meet every admitted task's deadlines.
+ * Return 1 if admitted, 0 if not.
+ */
+int SetDeadline(int period, int deadline, int budget);
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */